@@ -8,69 +8,263 @@
 #define CHECK 0
 
 
-DigitalAsset *create_asset_node(const char *hash, uint32_t size, uint8_t flags){
+// Skip list helpers.........
+// Level 0 of the skip list is the plain `next` list, a NULL predecessor stands for the header.
+
+
+// Start of the allocation of `node`: its tower, the next asset on level i (from 1) is at node[-i]
+DigitalAsset **asset_tower(DigitalAsset *node){
+  return (DigitalAsset **) node - (node->level - 1);
+}
+
+
+// Next asset after `node` on `level`, from the header when node is NULL
+DigitalAsset *asset_next(AssetIndex *index, DigitalAsset *node, int level){
+  if (!node) return index->first[level];
+  return level ? ((DigitalAsset **) node)[-level] : node->next;
+}
+
+
+void asset_set_next(AssetIndex *index, DigitalAsset *node, int level, DigitalAsset *next){
+  if (!node) index->first[level] = next;
+  else if (level) ((DigitalAsset **) node)[-level] = next;
+  else node->next = next;
+}
+
+
+void asset_free(DigitalAsset *node){
+  free(asset_tower(node));
+}
+
+
+// Random tower height, each level is kept by 1 in 4 nodes
+uint8_t asset_random_level(AssetIndex *index){
+  uint8_t level = 1;
+  while (level < ASSET_INDEX_MAX_LEVEL){
+    // xorshift32
+    index->random_state ^= index->random_state << 13;
+    index->random_state ^= index->random_state >> 17;
+    index->random_state ^= index->random_state << 5;
+    if (index->random_state & 3) break;
+    level++;
+  }
+  return level;
+}
+
+
+// Hash keys.........
+// The first ASSET_KEY_BYTES of a hash read as big endian words order the same way strcmp does,
+// so most comparisons are two word compares. Stored hashes are zero padded past the terminator.
+
+
+uint64_t asset_load_word(const char *bytes){
+  uint64_t word;
+  memcpy(&word, bytes, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+
+// Key words of a hash that is not stored in a node (no padding to rely on)
+void asset_make_key(const char *hash, uint64_t *key){
+  char bytes[ASSET_KEY_BYTES] = {0};
+  memcpy(bytes, hash, strnlen(hash, ASSET_KEY_BYTES));
+  key[0] = asset_load_word(bytes);
+  key[1] = asset_load_word(bytes + 8);
+}
+
+
+// Same result sign as compare_asset_hashes(asset->hash, hash)
+int asset_compare_key(const DigitalAsset *asset, const uint64_t *key, const char *hash){
+  uint64_t word = asset_load_word(asset->hash);
+  if (word != key[0]) return word < key[0] ? -1 : 1;
+  word = asset_load_word(asset->hash + 8);
+  if (word != key[1]) return word < key[1] ? -1 : 1;
+  return strcmp(asset->hash, hash);
+}
+
+
+// Hash table slot hash of `len` bytes of hash text, mixed a word at a time
+uint64_t asset_hash_text(const char *hash, size_t len){
+  uint64_t h = 0x9E3779B97F4A7C15ull ^ len;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8){
+    uint64_t word;
+    memcpy(&word, hash + i, sizeof(word));
+    h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+    h ^= h >> 32;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, hash + i, len - i);
+  h = (h ^ tail) * 0xC4CEB9FE1A85EC53ull;
+  return h ^ (h >> 29);
+}
+
+
+// Slot of `hash` in the table, or the empty slot where it would go
+size_t asset_table_slot(const AssetIndex *index, const char *hash, const uint64_t *key){
+  size_t mask = index->table_capacity - 1;
+  size_t slot = (size_t) asset_hash_text(hash, strlen(hash)) & mask;
+  while (index->table[slot] && asset_compare_key(index->table[slot], key, hash) != 0) slot = (slot + 1) & mask;
+  return slot;
+}
+
+
+// Makes room for one more asset, keeping the table at most 3/4 full
+// Returns: 0 - success, 1 - allocation failure (the old table is kept).
+int asset_table_reserve(AssetIndex *index){
+  if ((index->count + 1) * 4 <= index->table_capacity * 3) return 0;
+
+  size_t capacity = index->table_capacity ? index->table_capacity * 2 : 16;
+  DigitalAsset **table = (DigitalAsset **) calloc(capacity, sizeof(DigitalAsset *));
+  if (!table) return 1;
+
+  for (size_t i = 0; i < index->table_capacity; ++i){
+    DigitalAsset *asset = index->table[i];
+    if (!asset) continue;
+    size_t slot = (size_t) asset_hash_text(asset->hash, strlen(asset->hash)) & (capacity - 1);
+    while (table[slot]) slot = (slot + 1) & (capacity - 1);
+    table[slot] = asset;
+  }
+
+  free(index->table);
+  index->table = table;
+  index->table_capacity = capacity;
+  return 0;
+}
+
+
+// Empties `slot`, shifting back the entries of its probe run (no tombstones)
+void asset_table_remove(AssetIndex *index, size_t slot){
+  size_t mask = index->table_capacity - 1;
+  size_t next = slot;
+  while (1){
+    next = (next + 1) & mask;
+    DigitalAsset *asset = index->table[next];
+    if (!asset) break;
+
+    // An entry may move back unless its home slot lies between the hole and itself
+    size_t home = (size_t) asset_hash_text(asset->hash, strlen(asset->hash)) & mask;
+    if (((next - home) & mask) >= ((next - slot) & mask)){
+      index->table[slot] = asset;
+      slot = next;
+    }
+  }
+  index->table[slot] = NULL;
+}
+
+
+// Finds the last asset before `hash` on every level (NULL - the header)
+// Returns the first asset not before `hash`, or NULL
+DigitalAsset *asset_search(AssetIndex *index, const char *hash, DigitalAsset **update, AssetHashCompareFunc compare_func){
+  DigitalAsset *node = NULL;
+
+  // The default comparator goes through the key words
+  if (compare_func == compare_asset_hashes){
+    uint64_t key[2];
+    asset_make_key(hash, key);
+    for (int level = index->levels - 1; level >= 0; --level){
+      DigitalAsset *next = asset_next(index, node, level);
+      while (next && asset_compare_key(next, key, hash) < 0){
+        node = next;
+        next = asset_next(index, node, level);
+      }
+      update[level] = node;
+    }
+    return asset_next(index, node, 0);
+  }
+
+  for (int level = index->levels - 1; level >= 0; --level){
+    DigitalAsset *next = asset_next(index, node, level);
+    while (next && compare_func(next->hash, hash) < 0){
+      node = next;
+      next = asset_next(index, node, level);
+    }
+    update[level] = node;
+  }
+  return asset_next(index, node, 0);
+}
+
+
+// Creates a node with room for a tower of `level` before it, the hash is copied in after it
+DigitalAsset *create_asset_node_level(const char *hash, uint32_t size, uint8_t flags, uint8_t level){
   if (!hash) return NULL;
 
-  // Creating new node
-  DigitalAsset *new_asset = (DigitalAsset *) calloc(1, sizeof(DigitalAsset));
-  if(!new_asset) return NULL;
+  // Creating new node, the text is zero padded to at least ASSET_KEY_BYTES
+  size_t len = strlen(hash);
+  size_t text = len + 1 > ASSET_KEY_BYTES ? len + 1 : ASSET_KEY_BYTES;
+  DigitalAsset **tower = (DigitalAsset **) calloc(1, (level - 1) * sizeof(DigitalAsset *) + offsetof(DigitalAsset, hash) + text);
+  if(!tower) return NULL;
+  DigitalAsset *new_asset = (DigitalAsset *) (tower + level - 1);
 
   //Writing hash to the asset hash
-  new_asset->hash = strdup(hash);
-  if(!new_asset->hash){
-    free(new_asset);
-    return NULL;
-  }
+  memcpy(new_asset->hash, hash, len);
 
   //Write size, flags and set next to NULL
   new_asset->flags = flags;
   new_asset->size_bytes = size;
+  new_asset->level = level;
   new_asset->next = NULL;
+  new_asset->index = NULL;
 
   return new_asset;
 }
 
 
-ErrorCode insert_asset(DigitalAsset **head, const char *hash, uint32_t size, uint8_t flags, AssetHashCompareFunc compare_func){
-  if (!head || !hash || !compare_func) return ERROR_INVALID_ARGUMENT;
+DigitalAsset *create_asset_node(const char *hash, uint32_t size, uint8_t flags){
+  return create_asset_node_level(hash, size, flags, 1);
+}
 
-  // Creating new asset
-  DigitalAsset *new_asset = create_asset_node(hash, size, flags);
-  if (!new_asset) return ERROR_MEMORY_ALLOCATION_FAILED;
 
-  // If head is NULL set new node to head
-  DigitalAsset *current = *head;
-  DigitalAsset *previous = NULL;
-  if (!current){
-    *head = new_asset;
-    return SUCCESS;
+ErrorCode insert_asset(DigitalAsset **head, const char *hash, uint32_t size, uint8_t flags, AssetHashCompareFunc compare_func){
+  if (!head || !hash || !compare_func) return ERROR_INVALID_ARGUMENT;
+  if (*head && !(*head)->index) return ERROR_INVALID_ARGUMENT; // List not built by insert_asset
+
+  // First asset brings the header along
+  AssetIndex *index = *head ? (*head)->index : (AssetIndex *) calloc(1, sizeof(AssetIndex));
+  if (!index) return ERROR_MEMORY_ALLOCATION_FAILED;
+  if (!*head){
+    index->levels = 1;
+    index->random_state = 0x9E3779B9u;
   }
 
-  // Compare all nodes to insert by alphabetical order
-  while (current){
-    int comp = compare_func(new_asset->hash, current->hash);
-    if ( comp < 0 ){
-      if(!previous){ // If previous is NULL, it means current is the original head
-        new_asset->next = *head;
-        *head = new_asset;
-        return SUCCESS;
-      }
-      // Insertion in the middle of a list
-      new_asset->next = current;
-      previous->next = new_asset;
-      return SUCCESS;
-    }
-    else if (comp == 0){ // If our hash is duplicate
-      free(new_asset->hash);
-      free(new_asset);
-      return ERROR_DUPLICATE_ENTRY;
+  // Duplicates are found before anything is allocated
+  DigitalAsset *update[ASSET_INDEX_MAX_LEVEL];
+  DigitalAsset *current = asset_search(index, hash, update, compare_func);
+  if (current && compare_func(current->hash, hash) == 0) return ERROR_DUPLICATE_ENTRY;
+
+  // Creating new asset, a failed allocation leaves the list as it was
+  uint8_t level = asset_random_level(index);
+  DigitalAsset *new_asset = asset_table_reserve(index) ? NULL : create_asset_node_level(hash, size, flags, level);
+  if (!new_asset){
+    if (!*head){
+      free(index->table);
+      free(index);
     }
-    previous = current;
-    current = current->next;
+    return ERROR_MEMORY_ALLOCATION_FAILED;
   }
 
-  // Hash in new asset is the smallest insert at the end
-  previous->next = new_asset;
+  // New levels start at the header
+  for (int i = index->levels; i < level; ++i) update[i] = NULL;
+  if (level > index->levels) index->levels = level;
+
+  for (int i = 0; i < level; ++i){
+    asset_set_next(index, new_asset, i, asset_next(index, update[i], i));
+    asset_set_next(index, update[i], i, new_asset);
+  }
+  uint64_t key[2];
+  asset_make_key(hash, key);
+  index->table[asset_table_slot(index, hash, key)] = new_asset;
+  index->count++;
+
+  // Inserted before the old head, the header moves to the new one
+  if (!update[0]){
+    if (*head) (*head)->index = NULL;
+    new_asset->index = index;
+    *head = new_asset;
+  }
   return SUCCESS;
 }
 
@@ -78,6 +272,26 @@ ErrorCode insert_asset(DigitalAsset **head, const char *hash, uint32_t size, uin
 ErrorCode find_asset(DigitalAsset *head, const char *hash, DigitalAsset **found_asset, AssetHashCompareFunc compare_func){
   if (!head || !hash || !found_asset || !compare_func) return ERROR_INVALID_ARGUMENT;
 
+  // Exact match on the text, one probe in the hash table
+  if (head->index && compare_func == compare_asset_hashes){
+    uint64_t key[2];
+    asset_make_key(hash, key);
+    DigitalAsset *current = head->index->table[asset_table_slot(head->index, hash, key)];
+    if (!current) return ERROR_NOT_FOUND;
+
+    *found_asset = current;
+    return SUCCESS;
+  }
+
+  if (head->index){
+    DigitalAsset *update[ASSET_INDEX_MAX_LEVEL];
+    DigitalAsset *current = asset_search(head->index, hash, update, compare_func);
+    if (!current || compare_func(current->hash, hash) != 0) return ERROR_NOT_FOUND;
+
+    *found_asset = current;
+    return SUCCESS;
+  }
+
   // Searching for match in hashes
   DigitalAsset *current = head;
   while(current){
@@ -97,10 +311,13 @@ void clear_assets(DigitalAsset **head){
   if ( !head ) return;
 
   DigitalAsset *current = *head;
+  if (current && current->index){
+    free(current->index->table);
+    free(current->index);
+  }
   while(current){
     DigitalAsset *next = current->next;
-    free(current->hash);
-    free(current);
+    asset_free(current);
     current = next;
   }
 
@@ -193,25 +410,36 @@ ErrorCode save_assets_to_file(DigitalAsset *head, const char *filepath){
 }
 
 
-/**
- * @brief Deletes an asset from the list by its hash.
- * Important: This function must also handle the removal of all *references* to this asset
- * from users' `owned_assets` lists. You will need a mechanism to access the user list for this.
- * @param head Pointer to the pointer to the head of the DigitalAsset list.
- * @param hash Hash of the asset to delete.
- * @param compare_func Function pointer for comparing hashes.
- * @return ErrorCode.
- */
-ErrorCode delete_asset(DigitalAsset **head, const char *hash, AssetHashCompareFunc compare_func){ // TO DO end this function after users.c
+ErrorCode delete_asset(DigitalAsset **head, const char *hash, AssetHashCompareFunc compare_func){
   if (!head || !hash || !compare_func) return ERROR_INVALID_ARGUMENT;
+  if (!*head) return ERROR_EMPTY_LIST;
+  if (!(*head)->index) return ERROR_INVALID_ARGUMENT; // List not built by insert_asset
 
   // Searching for match in hashes for deletion
-  DigitalAsset *found = NULL;
-  ErrorCode error = find_asset(*head, hash, &found, compare_func);
-  if (error != SUCCESS) return error;
-
-  // TO DO >>>
+  AssetIndex *index = (*head)->index;
+  DigitalAsset *update[ASSET_INDEX_MAX_LEVEL];
+  DigitalAsset *found = asset_search(index, hash, update, compare_func);
+  if (!found || compare_func(found->hash, hash) != 0) return ERROR_NOT_FOUND;
+
+  // Unlinking the tower level by level
+  for (int i = 0; i < found->level; ++i) asset_set_next(index, update[i], i, asset_next(index, found, i));
+  while (index->levels > 1 && !index->first[index->levels - 1]) index->levels--;
+  uint64_t key[2];
+  asset_make_key(found->hash, key);
+  asset_table_remove(index, asset_table_slot(index, found->hash, key));
+  index->count--;
+
+  // Deleting the head hands the header to the next asset
+  if (found == *head){
+    *head = found->next;
+    if (*head) (*head)->index = index;
+    else {
+      free(index->table);
+      free(index);
+    }
+  }
 
+  asset_free(found);
   return SUCCESS;
 }
 
@@ -1,6 +1,7 @@
 #ifndef ASSETS_H
 #define ASSETS_H
 
+#include <stddef.h> // For size_t
 #include <stdint.h> // For uint32_t, uint8_t
 #include "errors.h" // For ErrorCode
 
@@ -12,16 +13,44 @@
 #define ASSET_FLAG_CORRUPTED   (1U << 3) // Asset is corrupted
 // You can add more flags as needed, e.g., ASSET_FLAG_SHARED, ASSET_FLAG_PUBLIC
 
+// Maximum height of a skip list tower, enough for 4^16 assets at 1 in 4 nodes per level.
+#define ASSET_INDEX_MAX_LEVEL 16
+// Leading bytes of a hash compared as two 64-bit words, the stored text is zero padded to at least this.
+#define ASSET_KEY_BYTES 16
+
+struct AssetIndex;
+
 /**
  * @brief Structure representing a single digital asset (file).
+ * The list is level 0 of a skip list: `next` still links every asset in alphabetical order,
+ * the higher levels skip ahead so insert, find and delete take O(log N) comparisons.
+ * A node is one allocation: the tower of level - 1 pointers to the next asset on levels
+ * 1 .. level - 1 sits right before the struct, the hash text right after `level` (in what
+ * would be the struct's tail padding).
  */
 typedef struct DigitalAsset {
-    char *hash;             // Unique identifier for the asset (e.g., SHA256 as a hex string). The node owns this memory.
+    struct DigitalAsset *next; // Pointer to the next asset in the singly linked list.
+    struct AssetIndex *index;  // Skip list header, set on the head node only (NULL on the others).
     uint32_t size_bytes;    // Size of the file in bytes.
     uint8_t flags;          // Bit flags indicating the asset's state.
-    struct DigitalAsset *next; // Pointer to the next asset in the singly linked list.
+    uint8_t level;          // Height of the node's tower, 1 means it is only linked through `next`.
+    char hash[];            // Unique identifier for the asset (e.g., SHA256 as a hex string), zero padded to at least ASSET_KEY_BYTES.
 } DigitalAsset;
 
+/**
+ * @brief Skip list header of an asset list, owned by its head node.
+ * Also holds an open addressing hash table of all assets keyed by the hash text,
+ * so exact lookups take O(1).
+ */
+typedef struct AssetIndex {
+    DigitalAsset *first[ASSET_INDEX_MAX_LEVEL]; // First asset on every level.
+    uint8_t levels;         // Levels in use.
+    uint32_t random_state;  // Generator of tower heights.
+    size_t count;           // Assets in the list.
+    DigitalAsset **table;   // Hash table slots, NULL when empty.
+    size_t table_capacity;  // Number of slots, a power of two kept at most 3/4 full.
+} AssetIndex;
+
 /**
  * @brief Function pointer for comparing two hashes (strings).
  * Returns <0 if hash1 < hash2, 0 if equal, >0 if hash1 > hash2.
@@ -37,7 +66,7 @@ typedef uint8_t (*StringBitPairCounter)(const char *str);
 // --- Function Prototypes for DigitalAsset List (Implement in assets.c) ---
 
 /**
- * @brief Creates a new DigitalAsset node.
+ * @brief Creates a new DigitalAsset node (with a tower of height 1, so it is freed with free()).
  * @param hash Unique asset hash (string).
  * @param size Size of the asset in bytes.
  * @param flags Bit flags for the asset.
@@ -47,6 +76,7 @@ DigitalAsset *create_asset_node(const char *hash, uint32_t size, uint8_t flags);
 
 /**
  * @brief Inserts a new asset into the list, maintaining alphabetical order by hash.
+ * The position is found through the skip list in O(log N) comparisons.
  * @param head Pointer to the pointer to the head of the DigitalAsset list.
  * @param hash Hash of the asset to insert.
  * @param size Size of the asset.
@@ -58,6 +88,9 @@ ErrorCode insert_asset(DigitalAsset **head, const char *hash, uint32_t size, uin
 
 /**
  * @brief Finds an asset in the list by its hash.
+ * With compare_asset_hashes the lookup goes through the hash table in O(1), other comparators
+ * search the skip list in O(log N) comparisons. Lists built without insert_asset (no index on
+ * the head) are searched linearly.
  * @param head Head of the DigitalAsset list.
  * @param hash Hash of the asset to find.
  * @param found_asset Pointer to a pointer where the found asset will be stored.
@@ -67,9 +100,9 @@ ErrorCode insert_asset(DigitalAsset **head, const char *hash, uint32_t size, uin
 ErrorCode find_asset(DigitalAsset *head, const char *hash, DigitalAsset **found_asset, AssetHashCompareFunc compare_func);
 
 /**
- * @brief Deletes an asset from the list by its hash.
- * Important: This function must also handle the removal of all *references* to this asset
- * from users' `owned_assets` lists. You will need a mechanism to access the user list for this.
+ * @brief Deletes an asset from the list by its hash and frees it.
+ * References in users' `owned_assets` lists are not visible from here, the caller has to drop
+ * them before deleting (see README.md).
  * @param head Pointer to the pointer to the head of the DigitalAsset list.
  * @param hash Hash of the asset to delete.
  * @param compare_func Function pointer for comparing hashes.
@@ -0,0 +1,172 @@
+// Benchmark of the asset list operations on generated SHA256-like hashes.
+// Build from this directory:
+//   gcc -std=gnu11 -O2 -o bench_assets bench_assets.c assets.c utils.c
+// Usage: ./bench_assets [assets] [baseline_assets]
+//   assets            assets inserted, found and deleted through the skip list (default 1000000)
+//   baseline_assets   assets run through a plain sorted list walked linearly, the way the
+//                     list worked before the skip list (default 20000, 0 skips it)
+// Every phase prints its total time and the time per operation.
+
+#include "assets.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HASH_LENGTH 64
+
+
+double now_ms(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e3 + (double) ts.tv_nsec / 1e6;
+}
+
+
+// xorshift64, the same run always generates the same hashes
+uint64_t next_random(uint64_t *state){
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+
+// Fills count hashes of HASH_LENGTH hex digits into one buffer, hash i at i * (HASH_LENGTH + 1)
+char *generate_hashes(size_t count, uint64_t seed){
+  static const char hex[] = "0123456789abcdef";
+  char *hashes = (char *) malloc(count * (HASH_LENGTH + 1));
+  if (!hashes) return NULL;
+
+  uint64_t state = seed;
+  for (size_t i = 0; i < count; ++i){
+    char *hash = hashes + i * (HASH_LENGTH + 1);
+    for (int j = 0; j < HASH_LENGTH; j += 16){
+      uint64_t bits = next_random(&state);
+      for (int k = 0; k < 16; ++k) hash[j + k] = hex[(bits >> (4 * k)) & 0xF];
+    }
+    hash[HASH_LENGTH] = '\0';
+  }
+  return hashes;
+}
+
+
+void report(const char *phase, size_t count, double ms){
+  printf("%-16s %9zu ops %10.1f ms %9.1f ns/op\n", phase, count, ms, ms * 1e6 / (double) (count ? count : 1));
+}
+
+
+// Sorted insertion walking the list from the head, as insert_asset did before the skip list
+ErrorCode linear_insert(DigitalAsset **head, const char *hash){
+  DigitalAsset **link = head;
+  while (*link){
+    int comp = compare_asset_hashes(hash, (*link)->hash);
+    if (comp == 0) return ERROR_DUPLICATE_ENTRY;
+    if (comp < 0) break;
+    link = &(*link)->next;
+  }
+
+  DigitalAsset *asset = create_asset_node(hash, 0, 0);
+  if (!asset) return ERROR_MEMORY_ALLOCATION_FAILED;
+  asset->next = *link;
+  *link = asset;
+  return SUCCESS;
+}
+
+
+int run_skip_list(const char *hashes, const char *missing, size_t count){
+  DigitalAsset *head = NULL;
+  DigitalAsset *found = NULL;
+  size_t hits = 0;
+
+  double start = now_ms();
+  for (size_t i = 0; i < count; ++i){
+    if (insert_asset(&head, hashes + i * (HASH_LENGTH + 1), (uint32_t) i, 0, compare_asset_hashes) != SUCCESS){
+      clear_assets(&head);
+      return 1;
+    }
+  }
+  report("insert", count, now_ms() - start);
+
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i) hits += find_asset(head, hashes + i * (HASH_LENGTH + 1), &found, compare_asset_hashes) == SUCCESS;
+  report("find (hit)", count, now_ms() - start);
+
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i) hits += find_asset(head, missing + i * (HASH_LENGTH + 1), &found, compare_asset_hashes) == SUCCESS;
+  report("find (miss)", count, now_ms() - start);
+
+  // Alphabetical iteration, as print_assets and save_assets_to_file do it
+  start = now_ms();
+  size_t listed = 0;
+  for (DigitalAsset *asset = head; asset; asset = asset->next) listed++;
+  report("iterate", listed, now_ms() - start);
+
+  // Every other asset, so both the head and inner towers are unlinked
+  start = now_ms();
+  size_t deleted = 0;
+  for (size_t i = 0; i < count; i += 2) deleted += delete_asset(&head, hashes + i * (HASH_LENGTH + 1), compare_asset_hashes) == SUCCESS;
+  report("delete", deleted, now_ms() - start);
+
+  start = now_ms();
+  clear_assets(&head);
+  report("clear", count - deleted, now_ms() - start);
+
+  return hits != count || listed != count || deleted != (count + 1) / 2;
+}
+
+
+int run_linear_list(const char *hashes, size_t count){
+  DigitalAsset *head = NULL;
+  DigitalAsset *found = NULL;
+  size_t hits = 0;
+
+  double start = now_ms();
+  for (size_t i = 0; i < count; ++i){
+    if (linear_insert(&head, hashes + i * (HASH_LENGTH + 1)) != SUCCESS){
+      clear_assets(&head);
+      return 1;
+    }
+  }
+  report("insert", count, now_ms() - start);
+
+  // Lists without an index on the head are searched linearly by find_asset
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i) hits += find_asset(head, hashes + i * (HASH_LENGTH + 1), &found, compare_asset_hashes) == SUCCESS;
+  report("find (hit)", count, now_ms() - start);
+
+  clear_assets(&head);
+  return hits != count;
+}
+
+
+int main(int argc, char **argv){
+  size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  size_t baseline = argc > 2 ? strtoul(argv[2], NULL, 10) : 20000;
+  if (!count){
+    fprintf(stderr, "usage: %s [assets] [baseline_assets]\n", argv[0]);
+    return 1;
+  }
+
+  // Random 256-bit hashes do not repeat, the second set is never inserted
+  char *hashes = generate_hashes(count > baseline ? count : baseline, 1);
+  char *missing = generate_hashes(count, 2);
+  if (!hashes || !missing){
+    free(hashes);
+    free(missing);
+    return 2;
+  }
+
+  printf("skip list, %zu assets\n", count);
+  int res = run_skip_list(hashes, missing, count);
+  if (!res && baseline){
+    printf("linear sorted list, %zu assets\n", baseline);
+    res = run_linear_list(hashes, baseline);
+  }
+  if (res) fprintf(stderr, "benchmark check failed\n");
+
+  free(hashes);
+  free(missing);
+  return res;
+}
@@ -0,0 +1,217 @@
+// Benchmark of the user store on generated mixed-case usernames.
+// Build from this directory:
+//   gcc -std=gnu11 -O2 -o bench_users bench_users.c users.c assets.c utils.c
+// Usage: ./bench_users [users] [random_inserts]
+//   users            users loaded from a shuffled and a sorted file, inserted in order, found and deleted (default 1000000)
+//   random_inserts   users inserted one by one in random order, each walking the list to its
+//                    position (default 20000, 0 skips it)
+// Every phase prints its total time and the time per operation.
+
+#include "users.h"
+#include "utils.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NAME_LENGTH 24
+#define FIRST_ID 100000u
+
+
+double now_ms(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e3 + (double) ts.tv_nsec / 1e6;
+}
+
+
+// xorshift64, the same run always generates the same names
+uint64_t next_random(uint64_t *state){
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+
+// Name i at i * NAME_LENGTH: a random mixed-case prefix and the index, so names never repeat
+char *generate_names(size_t count, uint64_t seed){
+  static const char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  char *names = (char *) malloc(count * NAME_LENGTH);
+  if (!names) return NULL;
+
+  uint64_t state = seed;
+  for (size_t i = 0; i < count; ++i){
+    char *name = names + i * NAME_LENGTH;
+    uint64_t bits = next_random(&state);
+    int length = 4 + (int) (bits % 8);
+    for (int j = 0; j < length; ++j) name[j] = letters[(bits >> (6 + 5 * j)) % 52];
+    snprintf(name + length, NAME_LENGTH - length, "_%zu", i);
+  }
+  return names;
+}
+
+
+// Shuffled order of count indexes
+size_t *shuffled(size_t count, uint64_t seed){
+  size_t *order = (size_t *) malloc(count * sizeof(size_t));
+  if (!order) return NULL;
+
+  uint64_t state = seed;
+  for (size_t i = 0; i < count; ++i) order[i] = i;
+  for (size_t i = count; i > 1; --i){
+    size_t j = next_random(&state) % i;
+    size_t swap = order[i - 1];
+    order[i - 1] = order[j];
+    order[j] = swap;
+  }
+  return order;
+}
+
+
+int compare_name_ptrs(const void *name1, const void *name2){
+  return compare_user_names(*(char *const *) name1, *(char *const *) name2);
+}
+
+
+void report(const char *phase, size_t count, double ms){
+  printf("%-16s %9zu ops %10.1f ms %9.1f ns/op\n", phase, count, ms, ms * 1e6 / (double) (count ? count : 1));
+}
+
+
+int run_store(const char *names, const size_t *order, size_t count, const char *path){
+  UserRecord *head = NULL;
+  UserRecord *found = NULL;
+  size_t hits = 0;
+
+  FILE *file = fopen(path, "w");
+  if (!file) return 1;
+  for (size_t i = 0; i < count; ++i) fprintf(file, "%s %u\n", names + order[i] * NAME_LENGTH, FIRST_ID + (uint32_t) order[i]);
+  fclose(file);
+
+  double start = now_ms();
+  ErrorCode error = load_users_from_file(&head, path, compare_user_names, NULL);
+  report("load (shuffled)", count, now_ms() - start);
+  remove(path);
+  clear_users(&head);
+  if (error != SUCCESS) return 1;
+
+  // Names sorted once up front so every insert takes the append path
+  char **in_order = (char **) malloc(count * sizeof(char *));
+  if (!in_order) return 1;
+  for (size_t i = 0; i < count; ++i) in_order[i] = (char *) names + i * NAME_LENGTH;
+  qsort(in_order, count, sizeof(char *), compare_name_ptrs);
+
+  // A file in name order, as save_users_to_file writes it, is one run for the sort
+  file = fopen(path, "w");
+  if (!file){
+    free(in_order);
+    return 1;
+  }
+  for (size_t i = 0; i < count; ++i) fprintf(file, "%s %u\n", in_order[i], FIRST_ID + (uint32_t) ((in_order[i] - names) / NAME_LENGTH));
+  fclose(file);
+
+  start = now_ms();
+  error = load_users_from_file(&head, path, compare_user_names, NULL);
+  report("load (sorted)", count, now_ms() - start);
+  remove(path);
+  clear_users(&head);
+  if (error != SUCCESS){
+    free(in_order);
+    return 1;
+  }
+
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i){
+    if (insert_user(&head, in_order[i], FIRST_ID + (uint32_t) ((in_order[i] - names) / NAME_LENGTH), compare_user_names) != SUCCESS){
+      free(in_order);
+      clear_users(&head);
+      return 1;
+    }
+  }
+  report("insert (in order)", count, now_ms() - start);
+  free(in_order);
+
+  // Lookups in upper case, the index folds them
+  char upper[NAME_LENGTH];
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i){
+    const char *name = names + order[i] * NAME_LENGTH;
+    size_t j = 0;
+    for ( ; name[j]; ++j) upper[j] = (char) toupper((unsigned char) name[j]);
+    upper[j] = '\0';
+    hits += find_user(head, upper, &found, compare_user_names) == SUCCESS;
+  }
+  report("find (name)", count, now_ms() - start);
+
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i) hits += find_user_by_id(head, FIRST_ID + (uint32_t) order[i], &found) == SUCCESS;
+  report("find (id)", count, now_ms() - start);
+
+  start = now_ms();
+  for (size_t i = 0; i < count; ++i) hits += find_user(head, "missing_user", &found, compare_user_names) == SUCCESS;
+  report("find (miss)", count, now_ms() - start);
+
+  start = now_ms();
+  size_t deleted = 0;
+  for (size_t i = 0; i < count; i += 2) deleted += delete_user(&head, names + order[i] * NAME_LENGTH, compare_user_names) == SUCCESS;
+  report("delete", deleted, now_ms() - start);
+
+  start = now_ms();
+  clear_users(&head);
+  report("clear", count - deleted, now_ms() - start);
+
+  return hits != 2 * count || deleted != (count + 1) / 2;
+}
+
+
+int run_random_inserts(const char *names, const size_t *order, size_t count){
+  UserRecord *head = NULL;
+
+  double start = now_ms();
+  for (size_t i = 0; i < count; ++i){
+    if (insert_user(&head, names + order[i] * NAME_LENGTH, FIRST_ID + (uint32_t) order[i], compare_user_names) != SUCCESS){
+      clear_users(&head);
+      return 1;
+    }
+  }
+  report("insert (random)", count, now_ms() - start);
+
+  clear_users(&head);
+  return 0;
+}
+
+
+int main(int argc, char **argv){
+  size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  size_t random_inserts = argc > 2 ? strtoul(argv[2], NULL, 10) : 20000;
+  if (!count){
+    fprintf(stderr, "usage: %s [users] [random_inserts]\n", argv[0]);
+    return 1;
+  }
+
+  size_t total = count > random_inserts ? count : random_inserts;
+  char *names = generate_names(total, 1);
+  size_t *order = shuffled(count, 2);
+  size_t *random_order = shuffled(random_inserts ? random_inserts : 1, 3);
+  if (!names || !order || !random_order){
+    free(names);
+    free(order);
+    free(random_order);
+    return 2;
+  }
+
+  printf("user store, %zu users\n", count);
+  int res = run_store(names, order, count, "bench_users.tmp");
+  if (!res && random_inserts){
+    printf("random order inserts, %zu users\n", random_inserts);
+    res = run_random_inserts(names, random_order, random_inserts);
+  }
+  if (res) fprintf(stderr, "benchmark check failed\n");
+
+  free(names);
+  free(order);
+  free(random_order);
+  return res;
+}
@@ -0,0 +1,590 @@
+#include "users.h"
+#include "errors.h"
+#include "utils.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Index helpers.........
+// Both tables use linear probing over the same capacity and delete by shifting entries back,
+// so there are no tombstones. The name table is keyed by the username folded to lowercase.
+
+
+// Hash of the case-folded username, a word at a time
+uint32_t user_name_hash(const char *username){
+  size_t length = strlen(username);
+  uint64_t h = 0x9E3779B97F4A7C15ull ^ length;
+  size_t i = 0;
+  for ( ; i + 8 <= length; i += 8){
+    uint64_t word;
+    memcpy(&word, username + i, sizeof(word));
+    h = (h ^ fold_word(word)) * 0xFF51AFD7ED558CCDull;
+    h ^= h >> 32;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, username + i, length - i);
+  h = (h ^ fold_word(tail)) * 0xC4CEB9FE1A85EC53ull;
+  return (uint32_t) (h >> 32);
+}
+
+
+uint64_t user_id_hash(uint32_t user_id){
+  uint64_t h = (uint64_t) user_id * 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 29);
+}
+
+
+size_t user_name_home(const UserRecord *user, size_t mask){
+  return (size_t) user->name_hash & mask;
+}
+
+
+size_t user_id_home(const UserRecord *user, size_t mask){
+  return (size_t) user_id_hash(user->user_id) & mask;
+}
+
+
+// Slot holding a user named `username` (any case), or the empty slot ending its probe run
+size_t user_name_slot(const UserIndex *index, const char *username){
+  size_t mask = index->capacity - 1;
+  uint32_t name_hash = user_name_hash(username);
+  size_t slot = (size_t) name_hash & mask;
+  while (index->by_name[slot]){
+    const UserRecord *user = index->by_name[slot];
+    if (user->name_hash == name_hash && compare_user_names(user->username, username) == 0) break;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+
+size_t user_id_slot(const UserIndex *index, uint32_t user_id){
+  size_t mask = index->capacity - 1;
+  size_t slot = (size_t) user_id_hash(user_id) & mask;
+  while (index->by_id[slot] && index->by_id[slot]->user_id != user_id) slot = (slot + 1) & mask;
+  return slot;
+}
+
+
+// First free slot of the probe run starting at `home`
+size_t user_free_slot(UserRecord **table, size_t mask, size_t home){
+  while (table[home]) home = (home + 1) & mask;
+  return home;
+}
+
+
+// Slot holding exactly `user` (names that only differ in case share a probe run)
+size_t user_table_find(UserRecord **table, size_t mask, const UserRecord *user, size_t (*home_func)(const UserRecord *, size_t)){
+  size_t slot = home_func(user, mask);
+  while (table[slot] != user) slot = (slot + 1) & mask;
+  return slot;
+}
+
+
+// Empties `slot`, moving back the entries whose home is not between the hole and themselves
+void user_table_remove(UserRecord **table, size_t mask, size_t slot, size_t (*home_func)(const UserRecord *, size_t)){
+  size_t next = slot;
+  while (1){
+    next = (next + 1) & mask;
+    UserRecord *user = table[next];
+    if (!user) break;
+
+    size_t home = home_func(user, mask);
+    if (((next - home) & mask) >= ((next - slot) & mask)){
+      table[slot] = user;
+      slot = next;
+    }
+  }
+  table[slot] = NULL;
+}
+
+
+// Makes room for one more user, keeping both tables at most 3/4 full
+// Returns: 0 - success, 1 - allocation failure (the old tables are kept).
+int user_index_reserve(UserIndex *index){
+  if ((index->count + 1) * 4 <= index->capacity * 3) return 0;
+
+  size_t capacity = index->capacity ? index->capacity * 2 : 16;
+  UserRecord **by_name = (UserRecord **) calloc(capacity, sizeof(UserRecord *));
+  UserRecord **by_id = (UserRecord **) calloc(capacity, sizeof(UserRecord *));
+  if (!by_name || !by_id){
+    free(by_name);
+    free(by_id);
+    return 1;
+  }
+
+  for (size_t i = 0; i < index->capacity; ++i){
+    UserRecord *user = index->by_name[i];
+    if (user) by_name[user_free_slot(by_name, capacity - 1, user_name_home(user, capacity - 1))] = user;
+    user = index->by_id[i];
+    if (user) by_id[user_free_slot(by_id, capacity - 1, user_id_home(user, capacity - 1))] = user;
+  }
+
+  free(index->by_name);
+  free(index->by_id);
+  index->by_name = by_name;
+  index->by_id = by_id;
+  index->capacity = capacity;
+  return 0;
+}
+
+
+// Adds `user` to both tables, room has to be reserved first
+void user_index_add(UserIndex *index, UserRecord *user){
+  size_t mask = index->capacity - 1;
+  index->by_name[user_free_slot(index->by_name, mask, user_name_home(user, mask))] = user;
+  index->by_id[user_free_slot(index->by_id, mask, user_id_home(user, mask))] = user;
+  index->count++;
+}
+
+
+void user_index_remove(UserIndex *index, UserRecord *user){
+  size_t mask = index->capacity - 1;
+  user_table_remove(index->by_name, mask, user_table_find(index->by_name, mask, user, user_name_home), user_name_home);
+  user_table_remove(index->by_id, mask, user_table_find(index->by_id, mask, user, user_id_home), user_id_home);
+  index->count--;
+}
+
+
+void free_user_index(UserIndex *index){
+  if (!index) return;
+  free(index->by_name);
+  free(index->by_id);
+  free(index);
+}
+
+
+// Makes `user` the head, moving the index over to it
+void user_set_head(UserRecord **head, UserRecord *user){
+  UserIndex *index = *head ? (*head)->index : NULL;
+  if (*head) (*head)->index = NULL;
+  if (user) user->index = index;
+  else free_user_index(index);
+  *head = user;
+}
+
+
+// Duplicate username or user id
+// Returns: 1 - taken, 0 - free.
+int user_taken(const UserRecord *head, const char *username, uint32_t user_id, UserNameCompareFunc compare_func){
+  const UserIndex *index = head->index;
+  if (index->by_id[user_id_slot(index, user_id)]) return 1;
+  if (compare_func == compare_user_names) return index->by_name[user_name_slot(index, username)] != NULL;
+
+  for (const UserRecord *user = head; user; user = user->next){
+    if (compare_func(user->username, username) == 0) return 1;
+  }
+  return 0;
+}
+
+
+// Creates the header of an empty list's first user
+UserIndex *create_user_index(void){
+  UserIndex *index = (UserIndex *) calloc(1, sizeof(UserIndex));
+  if (!index) return NULL;
+  if (user_index_reserve(index)){
+    free(index);
+    return NULL;
+  }
+  return index;
+}
+
+
+// Checks and indexes a new user without linking it, the caller links it in
+// Returns the new user, NULL with `error` set on failure
+UserRecord *user_admit(UserRecord **head, const char *username, uint32_t user_id, UserNameCompareFunc compare_func, ErrorCode *error){
+  *error = ERROR_INVALID_ARGUMENT;
+  if (*head && !(*head)->index) return NULL; // List not built by insert_user
+
+  UserIndex *index = *head ? (*head)->index : create_user_index();
+  *error = ERROR_MEMORY_ALLOCATION_FAILED;
+  if (!index) return NULL;
+
+  UserRecord *user = NULL;
+  if (*head && user_taken(*head, username, user_id, compare_func)) *error = ERROR_DUPLICATE_ENTRY;
+  else if (!user_index_reserve(index)) user = create_user_node(username, user_id);
+
+  if (!user){
+    if (!*head) free_user_index(index);
+    return NULL;
+  }
+
+  user_index_add(index, user);
+  if (!*head) user->index = index;
+  *error = SUCCESS;
+  return user;
+}
+
+
+// Links `user` at the end of the list
+void user_append(UserRecord **head, UserRecord *user){
+  if (!*head){
+    *head = user;
+  } else {
+    UserIndex *index = (*head)->index;
+    user->prev = index->tail;
+    index->tail->next = user;
+  }
+  (*head)->index->tail = user;
+}
+
+
+// Merges two sorted runs linked through `next`, ties keep `first` ahead
+UserRecord *merge_users(UserRecord *first, UserRecord *second, UserNameCompareFunc compare_func){
+  UserRecord *merged = NULL;
+  UserRecord **link = &merged;
+  while (first && second){
+    if (compare_func(second->username, first->username) < 0){
+      *link = second;
+      second = second->next;
+    } else {
+      *link = first;
+      first = first->next;
+    }
+    link = &(*link)->next;
+  }
+  *link = first ? first : second;
+  return merged;
+}
+
+
+// Stable natural merge sort of the whole list, then prev links, head and tail are rebuilt.
+// Already ordered stretches are taken as whole runs, so an ordered list costs N - 1 compares
+// and r runs O(N log r).
+void sort_users(UserRecord **head, UserNameCompareFunc compare_func){
+  if (!*head) return;
+  UserIndex *index = (*head)->index;
+  (*head)->index = NULL;
+
+  // runs[i] holds 2^i merged runs, older than the run being carried in
+  UserRecord *runs[64] = {NULL};
+  int used = 0;
+  UserRecord *list = *head;
+  while (list){
+    // Longest non-descending stretch starting at list
+    UserRecord *run = list;
+    UserRecord *last = list;
+    while (last->next && compare_func(last->next->username, last->username) >= 0) last = last->next;
+    list = last->next;
+    last->next = NULL;
+
+    int i = 0;
+    for ( ; i < 63 && runs[i]; ++i){
+      run = merge_users(runs[i], run, compare_func);
+      runs[i] = NULL;
+    }
+    runs[i] = run;
+    if (i >= used) used = i + 1;
+  }
+
+  UserRecord *sorted = NULL;
+  for (int i = 0; i < used; ++i) sorted = merge_users(runs[i], sorted, compare_func);
+
+  UserRecord *prev = NULL;
+  for (UserRecord *user = sorted; user; user = user->next){
+    user->prev = prev;
+    prev = user;
+  }
+  *head = sorted;
+  sorted->index = index;
+  index->tail = prev;
+}
+
+
+// Appends a reference to `asset` unless the user already owns it
+ErrorCode user_add_asset(UserRecord *user, DigitalAsset *asset){
+  UserAssetRef **link = &user->owned_assets;
+  while (*link){
+    if ((*link)->asset_ptr == asset) return ERROR_DUPLICATE_ENTRY;
+    link = &(*link)->next;
+  }
+
+  UserAssetRef *ref = (UserAssetRef *) malloc(sizeof(UserAssetRef));
+  if (!ref) return ERROR_MEMORY_ALLOCATION_FAILED;
+  ref->asset_ptr = asset;
+  ref->next = NULL;
+  *link = ref;
+  return SUCCESS;
+}
+
+
+void free_user(UserRecord *user){
+  UserAssetRef *ref = user->owned_assets;
+  while (ref){
+    UserAssetRef *next = ref->next;
+    free(ref);
+    ref = next;
+  }
+  free(user);
+}
+
+
+// Creates a node with the username copied in after the record
+UserRecord *create_user_node(const char *username, uint32_t user_id){
+  if (!username || !*username) return NULL;
+
+  size_t length = strlen(username);
+  UserRecord *new_user = (UserRecord *) calloc(1, sizeof(UserRecord) + length + 1);
+  if (!new_user) return NULL;
+
+  new_user->username = (char *) (new_user + 1);
+  memcpy(new_user->username, username, length + 1);
+  new_user->user_id = user_id;
+  new_user->name_hash = user_name_hash(username);
+  new_user->owned_assets = NULL;
+  new_user->prev = NULL;
+  new_user->next = NULL;
+  new_user->index = NULL;
+
+  return new_user;
+}
+
+
+ErrorCode insert_user(UserRecord **head, const char *username, uint32_t user_id, UserNameCompareFunc compare_func){
+  if (!head || !username || !*username || !compare_func) return ERROR_INVALID_ARGUMENT;
+
+  ErrorCode error;
+  UserRecord *new_user = user_admit(head, username, user_id, compare_func, &error);
+  if (!new_user) return error;
+
+  // In order after the last user (also the first user of an empty list)
+  UserIndex *index = *head ? (*head)->index : new_user->index;
+  if (!*head || compare_func(index->tail->username, username) <= 0){
+    user_append(head, new_user);
+    return SUCCESS;
+  }
+
+  // Walking to the first user sorting after the new one, which exists as the tail does
+  UserRecord *next = *head;
+  while (compare_func(next->username, username) <= 0) next = next->next;
+
+  new_user->prev = next->prev;
+  new_user->next = next;
+  if (next->prev) next->prev->next = new_user;
+  next->prev = new_user;
+  if (next == *head) user_set_head(head, new_user);
+  return SUCCESS;
+}
+
+
+ErrorCode find_user(UserRecord *head, const char *username, UserRecord **found_user, UserNameCompareFunc compare_func){
+  if (!head || !username || !found_user || !compare_func) return ERROR_INVALID_ARGUMENT;
+
+  // Any case of the name, one probe in the name index
+  if (head->index && compare_func == compare_user_names){
+    UserRecord *user = head->index->by_name[user_name_slot(head->index, username)];
+    if (!user) return ERROR_NOT_FOUND;
+
+    *found_user = user;
+    return SUCCESS;
+  }
+
+  for (UserRecord *user = head; user; user = user->next){
+    if (compare_func(user->username, username) == 0){
+      *found_user = user;
+      return SUCCESS;
+    }
+  }
+  return ERROR_NOT_FOUND;
+}
+
+
+ErrorCode find_user_by_id(UserRecord *head, uint32_t user_id, UserRecord **found_user){
+  if (!head || !found_user) return ERROR_INVALID_ARGUMENT;
+
+  if (head->index){
+    UserRecord *user = head->index->by_id[user_id_slot(head->index, user_id)];
+    if (!user) return ERROR_NOT_FOUND;
+
+    *found_user = user;
+    return SUCCESS;
+  }
+
+  for (UserRecord *user = head; user; user = user->next){
+    if (user->user_id == user_id){
+      *found_user = user;
+      return SUCCESS;
+    }
+  }
+  return ERROR_NOT_FOUND;
+}
+
+
+ErrorCode delete_user(UserRecord **head, const char *username, UserNameCompareFunc compare_func){
+  if (!head || !username || !compare_func) return ERROR_INVALID_ARGUMENT;
+  if (!*head) return ERROR_EMPTY_LIST;
+  if (!(*head)->index) return ERROR_INVALID_ARGUMENT; // List not built by insert_user
+
+  UserRecord *user = NULL;
+  ErrorCode error = find_user(*head, username, &user, compare_func);
+  if (error != SUCCESS) return error;
+
+  UserIndex *index = (*head)->index;
+  user_index_remove(index, user);
+  if (index->tail == user) index->tail = user->prev;
+
+  // Unlinking, deleting the head hands the index to the next user
+  if (user->next) user->next->prev = user->prev;
+  if (user->prev) user->prev->next = user->next;
+  else user_set_head(head, user->next);
+
+  free_user(user);
+  return SUCCESS;
+}
+
+
+void clear_users(UserRecord **head){
+  if (!head) return;
+
+  UserRecord *current = *head;
+  if (current) free_user_index(current->index);
+  while (current){
+    UserRecord *next = current->next;
+    free_user(current);
+    current = next;
+  }
+
+  *head = NULL;
+}
+
+
+void print_users(UserRecord *head){
+  for (UserRecord *user = head; user; user = user->next){
+    printf("%s | ID: %u | Assets:", user->username, user->user_id);
+    if (!user->owned_assets) printf(" none");
+    for (UserAssetRef *ref = user->owned_assets; ref; ref = ref->next) printf(" %s", ref->asset_ptr->hash);
+    printf("\n");
+  }
+}
+
+
+ErrorCode assign_asset_to_user(UserRecord *user_head, DigitalAsset *asset_head, const char *username, const char *asset_hash, UserNameCompareFunc user_compare, AssetHashCompareFunc asset_compare){
+  if (!user_head || !asset_head || !username || !asset_hash || !user_compare || !asset_compare) return ERROR_INVALID_ARGUMENT;
+
+  UserRecord *user = NULL;
+  ErrorCode error = find_user(user_head, username, &user, user_compare);
+  if (error != SUCCESS) return error;
+
+  DigitalAsset *asset = NULL;
+  error = find_asset(asset_head, asset_hash, &asset, asset_compare);
+  if (error != SUCCESS) return error;
+
+  return user_add_asset(user, asset);
+}
+
+
+ErrorCode remove_asset_from_user(UserRecord *user_head, const char *username, const char *asset_hash, UserNameCompareFunc user_compare, AssetHashCompareFunc asset_compare){
+  if (!user_head || !username || !asset_hash || !user_compare || !asset_compare) return ERROR_INVALID_ARGUMENT;
+
+  UserRecord *user = NULL;
+  ErrorCode error = find_user(user_head, username, &user, user_compare);
+  if (error != SUCCESS) return error;
+
+  for (UserAssetRef **link = &user->owned_assets; *link; link = &(*link)->next){
+    if (asset_compare((*link)->asset_ptr->hash, asset_hash) == 0){
+      UserAssetRef *ref = *link;
+      *link = ref->next;
+      free(ref);
+      return SUCCESS;
+    }
+  }
+  return ERROR_NOT_FOUND;
+}
+
+
+size_t remove_asset_references(UserRecord *user_head, const DigitalAsset *asset){
+  size_t removed = 0;
+  for (UserRecord *user = user_head; user; user = user->next){
+    UserAssetRef **link = &user->owned_assets;
+    while (*link){
+      if ((*link)->asset_ptr != asset){
+        link = &(*link)->next;
+        continue;
+      }
+      UserAssetRef *ref = *link;
+      *link = ref->next;
+      free(ref);
+      removed++;
+    }
+  }
+  return removed;
+}
+
+
+// Parses one line (comment already cut off) into a new user appended to the list
+ErrorCode load_user_line(UserRecord **head, char *line, UserNameCompareFunc compare_func, DigitalAsset *main_asset_list_head){
+  char *save = NULL;
+  char *username = strtok_r(line, " \t\r\n", &save);
+  if (!username) return SUCCESS; // Empty line
+
+  char *id_text = strtok_r(NULL, " \t\r\n", &save);
+  char *end = NULL;
+  unsigned long user_id = id_text ? strtoul(id_text, &end, 10) : 0;
+  if (!id_text || *end || !isdigit((unsigned char) *id_text) || user_id > UINT32_MAX) return ERROR_FILE_CORRUPTED;
+
+  ErrorCode error;
+  UserRecord *user = user_admit(head, username, (uint32_t) user_id, compare_func, &error);
+  if (!user) return error;
+  user_append(head, user);
+
+  for (char *hash = strtok_r(NULL, " \t\r\n", &save); hash; hash = strtok_r(NULL, " \t\r\n", &save)){
+    DigitalAsset *asset = NULL;
+    if (!main_asset_list_head || find_asset(main_asset_list_head, hash, &asset, compare_asset_hashes) != SUCCESS) continue;
+
+    error = user_add_asset(user, asset);
+    if (error == ERROR_MEMORY_ALLOCATION_FAILED) return error;
+  }
+  return SUCCESS;
+}
+
+
+ErrorCode load_users_from_file(UserRecord **head, const char *filepath, UserNameCompareFunc compare_func, DigitalAsset *main_asset_list_head){
+  if (!head || !filepath || !compare_func) return ERROR_INVALID_ARGUMENT;
+  if (*head && !(*head)->index) return ERROR_INVALID_ARGUMENT; // List not built by insert_user
+
+  FILE *file = fopen(filepath, "r");
+  if (!file) return ERROR_FILE_NOT_FOUND;
+
+  // Lines can list any number of assets
+  char *line = NULL;
+  size_t capacity = 0;
+  ErrorCode error = SUCCESS;
+
+  // Users are appended as read, the list is sorted once at the end
+  while (error == SUCCESS && getline(&line, &capacity, file) != -1){
+    char *comment_start = strchr(line, ';');
+    if (comment_start) *comment_start = '\0';
+    error = load_user_line(head, line, compare_func, main_asset_list_head);
+  }
+
+  free(line);
+  fclose(file);
+  if (error != SUCCESS){
+    clear_users(head);
+    return error;
+  }
+
+  sort_users(head, compare_func);
+  return SUCCESS;
+}
+
+
+ErrorCode save_users_to_file(UserRecord *head, const char *filepath){
+  if (!head || !filepath) return ERROR_INVALID_ARGUMENT;
+
+  FILE *file = fopen(filepath, "w");
+  if (!file) return ERROR_FILE_NOT_FOUND;
+
+  for (UserRecord *user = head; user; user = user->next){
+    fprintf(file, "%s %u", user->username, user->user_id);
+    for (UserAssetRef *ref = user->owned_assets; ref; ref = ref->next) fprintf(file, " %s", ref->asset_ptr->hash);
+    fprintf(file, "\n");
+  }
+
+  int failed = ferror(file);
+  if (fclose(file) != 0 || failed) return ERROR_OTHER;
+  return SUCCESS;
+}
@@ -15,19 +15,37 @@ typedef struct UserAssetRef {
     struct UserAssetRef *next; // Pointer to the next asset reference in the user's list.
 } UserAssetRef;
 
+struct UserIndex;
+
 /**
  * @brief Structure representing a user record in a doubly linked list.
+ * The list stays in alphabetical order; the head node also owns the lookup tables of the list.
  */
 typedef struct UserRecord {
-    char *username;         // Username. The node owns this memory.
+    char *username;         // Username. Stored in the node's own allocation, freed with it.
     uint32_t user_id;       // Unique user identifier.
+    uint32_t name_hash;     // Hash of the case-folded username, kept for the name index.
     UserAssetRef *owned_assets; // Head of a singly linked list of pointers to DigitalAssets owned by this user.
                                 // THIS list (UserAssetRef nodes) is allocated and freed BY the UserRecord,
                                 // but the *DigitalAsset pointed to* is NOT.
     struct UserRecord *prev; // Pointer to the previous record in the doubly linked list.
     struct UserRecord *next; // Pointer to the next record in the doubly linked list.
+    struct UserIndex *index; // Lookup tables, set on the head node only (NULL on the others).
 } UserRecord;
 
+/**
+ * @brief Hash indexes of a user list, owned by its head node.
+ * Open addressing tables over the case-folded username and over user_id,
+ * so finding a user by either takes O(1).
+ */
+typedef struct UserIndex {
+    UserRecord **by_name;   // Slots keyed by the case-folded username.
+    UserRecord **by_id;     // Slots keyed by user_id.
+    size_t capacity;        // Slots in each table, a power of two kept at most 3/4 full.
+    size_t count;           // Users in the list.
+    UserRecord *tail;       // Last user in the list.
+} UserIndex;
+
 /**
  * @brief Function pointer for comparing two usernames (strings).
  * Returns <0 if name1 < name2, 0 if equal, >0 if name1 > name2.
@@ -47,6 +65,8 @@ UserRecord *create_user_node(const char *username, uint32_t user_id);
 
 /**
  * @brief Inserts a new user into the doubly linked list, maintaining alphabetical order by username.
+ * Usernames and user ids are unique. Both are checked through the indexes; a name that sorts after
+ * the last user is appended in O(1), other names walk the list to their position.
  * @param head Pointer to the pointer to the head of the UserRecord list.
  * @param username Username to insert.
  * @param user_id User ID.
@@ -57,6 +77,8 @@ ErrorCode insert_user(UserRecord **head, const char *username, uint32_t user_id,
 
 /**
  * @brief Finds a user in the list by username.
+ * With compare_user_names the lookup goes through the name index in O(1), other comparators and
+ * lists built without insert_user (no index on the head) are searched linearly.
  * @param head Head of the UserRecord list.
  * @param username Username to find.
  * @param found_user Pointer to a pointer where the found user will be stored.
@@ -65,6 +87,15 @@ ErrorCode insert_user(UserRecord **head, const char *username, uint32_t user_id,
  */
 ErrorCode find_user(UserRecord *head, const char *username, UserRecord **found_user, UserNameCompareFunc compare_func);
 
+/**
+ * @brief Finds a user in the list by user id, in O(1) through the id index.
+ * @param head Head of the UserRecord list.
+ * @param user_id User ID to find.
+ * @param found_user Pointer to a pointer where the found user will be stored.
+ * @return ErrorCode.
+ */
+ErrorCode find_user_by_id(UserRecord *head, uint32_t user_id, UserRecord **found_user);
+
 /**
  * @brief Deletes a user from the list by username.
  * Important: This function must free memory only for the UserRecord node and its internal UserAssetRef list,
@@ -113,11 +144,23 @@ ErrorCode assign_asset_to_user(UserRecord *user_head, DigitalAsset *asset_head,
  */
 ErrorCode remove_asset_from_user(UserRecord *user_head, const char *username, const char *asset_hash, UserNameCompareFunc user_compare, AssetHashCompareFunc asset_compare);
 
+/**
+ * @brief Removes every user's reference to an asset, to be called before delete_asset frees it.
+ * @param user_head Head of the UserRecord list.
+ * @param asset The asset about to be deleted.
+ * @return Number of references removed.
+ */
+size_t remove_asset_references(UserRecord *user_head, const DigitalAsset *asset);
+
 /**
  * @brief Loads users from a file into the list.
  * File format (example): username user_id asset_hash1 asset_hash2 ...
  * Important: When loading, you must find the corresponding DigitalAsset in the main list (main_asset_list_head)
  * and add pointers to these *existing* DigitalAssets to the user's owned_assets list.
+ * Records are appended as they are read and the list is merge sorted once at the end, taking
+ * ordered stretches as whole runs: a file already in name order (as save_users_to_file writes it)
+ * loads in O(N), a file in r ordered runs in O(N log r), a shuffled one in O(N log N). Hashes missing from the asset list and repeated
+ * hashes of one user are skipped. On any error the whole user list is cleared.
  * @param head Pointer to the pointer to the head of the UserRecord list.
  * @param filepath Path to the file.
  * @param compare_func Function pointer for comparing usernames (for insertion).
@@ -127,7 +170,7 @@ ErrorCode remove_asset_from_user(UserRecord *user_head, const char *username, co
 ErrorCode load_users_from_file(UserRecord **head, const char *filepath, UserNameCompareFunc compare_func, DigitalAsset *main_asset_list_head);
 
 /**
- * @brief Saves users and their assigned assets to a file.
+ * @brief Saves users and their assigned assets to a file, in the format load_users_from_file reads.
  * @param head Head of the UserRecord list.
  * @param filepath Path to the file.
  * @return ErrorCode.
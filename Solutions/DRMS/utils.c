@@ -3,39 +3,103 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__GNUC__) && defined(__SSE2__)
+#define BIT_PAIR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// All the bits of a type_name value, for integer types of up to 64 bits.
+#define BIT_PAIR_TYPE_BITS(type_name) (~0ull >> (64 - sizeof(type_name) * 8))
+
 // Macro generating a function to count '01' bit pairs in a given numeric type.
 // E.g., CREATE_BIT_PAIR_COUNT_FUNC(char) will create a prototype: uint8_t count_01_pairs_char(char val);
-#define CREATE_BIT_PAIR_COUNT_FUNC(type_name)              \
-  uint8_t count_01_pairs_in_##type_name(type_name val){    \
-    uint8_t pairs = 0;                                     \
-    int size = sizeof(type_name) * 8;                      \
-    for (int i = 0; i < (size - 1); ++i){                  \
-      if (val & (1u << i)){                                \
-        if(!(val & (1u << (i + 1)))){                      \
-          pairs++;                                         \
-        }                                                  \
-      }                                                    \
-    }                                                      \
-    return pairs;                                          \
-  }                                                        \
+// A pair is a set bit whose next higher bit is clear, so the pairs are the set bits of
+// val & ~(val >> 1) below the top bit of the type, counted with one popcount.
+#define CREATE_BIT_PAIR_COUNT_FUNC(type_name)                                                   \
+  uint8_t count_01_pairs_in_##type_name(type_name val){                                         \
+    uint64_t bits = (uint64_t) val & BIT_PAIR_TYPE_BITS(type_name);                             \
+    return (uint8_t) __builtin_popcountll(bits & ~(bits >> 1) & (BIT_PAIR_TYPE_BITS(type_name) >> 1)); \
+  }                                                                                             \
 
 // Macro generating a function to count '01' bit pairs in each byte of a string.
 // This function will be used for hashes and names.
-// In its implementation, you will need to call the count_01_pairs_char function.
+// The count is kept in a uint8_t like before and wraps on long strings,
+// count_01_pairs_in_bytes returns the full count.
 #define CREATE_STRING_BIT_PAIR_COUNT_FUNC(func_name)       \
   uint8_t func_name(const char *str){                      \
-    int length = strlen(str);                              \
-    uint8_t pairs = 0;                                     \
-    for (int i = 0; i < length; ++i){                      \
-      pairs += count_01_pairs_in_char(*(str + i));         \
-    }                                                      \
-    return pairs;                                          \
+    return (uint8_t) count_01_pairs_in_bytes(str, strlen(str)); \
   }                                                        \
 
 
+// Pairs in every byte value, for the byte at a time paths
+#define BIT_PAIRS_IN_BYTE(v) ((uint8_t) __builtin_popcount((v) & ~((v) >> 1) & 0x7F))
+#define BIT_PAIRS_ROW2(v) BIT_PAIRS_IN_BYTE(v), BIT_PAIRS_IN_BYTE(v + 1)
+#define BIT_PAIRS_ROW4(v) BIT_PAIRS_ROW2(v), BIT_PAIRS_ROW2(v + 2)
+#define BIT_PAIRS_ROW16(v) BIT_PAIRS_ROW4(v), BIT_PAIRS_ROW4(v + 4), BIT_PAIRS_ROW4(v + 8), BIT_PAIRS_ROW4(v + 12)
+#define BIT_PAIRS_ROW64(v) BIT_PAIRS_ROW16(v), BIT_PAIRS_ROW16(v + 16), BIT_PAIRS_ROW16(v + 32), BIT_PAIRS_ROW16(v + 48)
+
+const uint8_t bit_pairs_in_byte[256] = {
+  BIT_PAIRS_ROW64(0), BIT_PAIRS_ROW64(64), BIT_PAIRS_ROW64(128), BIT_PAIRS_ROW64(192)
+};
+
+
+size_t count_01_pairs_in_bytes_scalar(const unsigned char *data, size_t length){
+  size_t pairs = 0;
+  for (size_t i = 0; i < length; ++i) pairs += bit_pairs_in_byte[data[i]];
+  return pairs;
+}
+
+
+#ifdef BIT_PAIR_SSE2
+// 16 bytes per step: the pair bits of every byte, a bytewise popcount, then a sum of
+// absolute differences against zero adds the bytes into two 64-bit counters.
+// The 16-bit shift pulls the next byte's low bit into bit 7, which the 0x7F mask drops.
+__attribute__((target("sse2")))
+size_t count_01_pairs_in_bytes_sse2(const unsigned char *data, size_t length){
+  const __m128i low7 = _mm_set1_epi8(0x7F);
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0F);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i total = zero;
+  size_t i = 0;
+
+  for ( ; i + 16 <= length; i += 16){
+    __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+    __m128i x = _mm_and_si128(_mm_andnot_si128(_mm_srli_epi16(v, 1), v), low7);
+    x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+    x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2));
+    x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi16(x, 4)), m4);
+    total = _mm_add_epi64(total, _mm_sad_epu8(x, zero));
+  }
+
+  uint64_t lanes[2];
+  _mm_storeu_si128((__m128i *) lanes, total);
+  return (size_t) (lanes[0] + lanes[1]) + count_01_pairs_in_bytes_scalar(data + i, length - i);
+}
+#endif
+
+
+size_t count_01_pairs_in_bytes(const char *data, size_t length){
+#ifdef BIT_PAIR_SSE2
+  return count_01_pairs_in_bytes_sse2((const unsigned char *) data, length);
+#else
+  return count_01_pairs_in_bytes_scalar((const unsigned char *) data, length);
+#endif
+}
+
+
 // Declare a specific instance for 'char' so it can be used in the string counting function.
 CREATE_BIT_PAIR_COUNT_FUNC(char)
-// Declare the function to count '01' pairs in strings, which will use count_01_pairs_char.
+// The other integer types.
+CREATE_BIT_PAIR_COUNT_FUNC(short)
+CREATE_BIT_PAIR_COUNT_FUNC(int)
+CREATE_BIT_PAIR_COUNT_FUNC(long)
+CREATE_BIT_PAIR_COUNT_FUNC(uint8_t)
+CREATE_BIT_PAIR_COUNT_FUNC(uint16_t)
+CREATE_BIT_PAIR_COUNT_FUNC(uint32_t)
+CREATE_BIT_PAIR_COUNT_FUNC(uint64_t)
+// Declare the function to count '01' pairs in strings.
 CREATE_STRING_BIT_PAIR_COUNT_FUNC(count_01_pairs_in_string)
 
 
@@ -47,31 +111,55 @@ int compare_asset_hashes(const char *hash1, const char *hash2){
   return strcmp(hash1, hash2);
 }
 
+// Lowercases the ASCII letters of 8 bytes at once, other bytes are left as they are (like
+// tolower in the C locale). A byte is a letter when adding 0x80 - 'A' sets its top bit and
+// adding 0x80 - 'Z' - 1 does not; computed on the low 7 bits so no carry crosses bytes.
+uint64_t fold_word(uint64_t word){
+  const uint64_t high = 0x8080808080808080ull;
+  const uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+  const uint64_t ones = 0x0101010101010101ull;
+
+  uint64_t heptets = word & low7;
+  uint64_t from_a = heptets + ones * (0x80 - 'A');
+  uint64_t past_z = heptets + ones * (0x80 - 'Z' - 1);
+  uint64_t upper = (from_a ^ past_z) & ~word & high;
+  return word | (upper >> 2);
+}
+
+
 /**
   @brief Function for comparing two usernames (strings).
-  Implement simple case-insensitivity (e.g., convert to lowercase for comparison).
+  Case-insensitive for ASCII letters, without allocating: both names are folded 8 bytes at a time.
   @return <0 if name1 < name2, 0 if equal, >0 if name1 > name2.
 */
 int compare_user_names(const char *name1, const char *name2){
+  size_t length1 = strlen(name1);
+  size_t length2 = strlen(name2);
+  size_t length = length1 < length2 ? length1 : length2;
+  size_t i = 0;
 
-  char *lower_name1 = strdup(name1);
-
-  char *lower_name2 = strdup(name2);
-  if(!lower_name2){
-    free(lower_name1);
-    return 0;
+  for ( ; i + 8 <= length; i += 8){
+    uint64_t word1, word2;
+    memcpy(&word1, name1 + i, sizeof(word1));
+    memcpy(&word2, name2 + i, sizeof(word2));
+    word1 = fold_word(word1);
+    word2 = fold_word(word2);
+    if (word1 != word2){
+      // The first differing byte decides, in memory order
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      word1 = __builtin_bswap64(word1);
+      word2 = __builtin_bswap64(word2);
+#endif
+      return word1 < word2 ? -1 : 1;
+    }
   }
 
-  char *temp1 = lower_name1;
-  char *temp2 = lower_name2;
-
-  for ( ; *temp1; ++temp1) *temp1 = tolower((unsigned char)*temp1);
-  for ( ; *temp2; ++temp2) *temp2 = tolower((unsigned char)*temp2);
-
-  int result = strcmp(lower_name1, lower_name2);
-
-  free(lower_name1);
-  free(lower_name2);
+  for ( ; i < length; ++i){
+    int c1 = tolower((unsigned char) name1[i]);
+    int c2 = tolower((unsigned char) name2[i]);
+    if (c1 != c2) return c1 - c2;
+  }
 
-  return result;
+  // Equal up to the shorter name, which sorts first
+  return (length1 > length2) - (length1 < length2);
 }
@@ -1,22 +1,44 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 // --- Prototypes of comparison functions (implement in utils.c or main.c) ---
 
+// '01' bit pairs: set bits whose next higher bit is clear, within the width of the type.
 uint8_t count_01_pairs_in_char(char val);
+uint8_t count_01_pairs_in_short(short val);
+uint8_t count_01_pairs_in_int(int val);
+uint8_t count_01_pairs_in_long(long val);
+uint8_t count_01_pairs_in_uint8_t(uint8_t val);
+uint8_t count_01_pairs_in_uint16_t(uint16_t val);
+uint8_t count_01_pairs_in_uint32_t(uint32_t val);
+uint8_t count_01_pairs_in_uint64_t(uint64_t val);
+
+// Pairs in each byte of a string, wrapping at 256 (use count_01_pairs_in_bytes for the full count).
 uint8_t count_01_pairs_in_string(const char *str);
 
+/**
+  @brief Counts '01' bit pairs in each of `length` bytes, 16 bytes at a time with SSE2.
+  @return The total count, without the wrap of count_01_pairs_in_string.
+*/
+size_t count_01_pairs_in_bytes(const char *data, size_t length);
+
 /**
   @brief Function for comparing two hashes (strings).
   @return <0 if hash1 < hash2, 0 if equal, >0 if hash1 > hash2.
 */
 int compare_asset_hashes(const char *hash1, const char *hash2);
 
+/**
+  @brief Lowercases the ASCII letters in 8 packed bytes, other bytes are unchanged.
+*/
+uint64_t fold_word(uint64_t word);
+
 /**
   @brief Function for comparing two usernames (strings).
-  Implement simple case-insensitivity (e.g., convert to lowercase for comparison).
+  Case-insensitive for ASCII letters (tolower in the C locale), allocation-free.
   @return <0 if name1 < name2, 0 if equal, >0 if name1 > name2.
 */
 int compare_user_names(const char *name1, const char *name2);
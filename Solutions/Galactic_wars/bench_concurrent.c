@@ -0,0 +1,244 @@
+// Reader throughput against one busy writer, with and without the epoch-based
+// concurrent layer, and a stress check of its publication rules.
+// Build from this directory:
+//   gcc -std=gnu11 -O2 -pthread -o bench_concurrent bench_concurrent.c $(ls *.c | grep -v -e '^main.c$' -e '^bench')
+// Usage: ./bench_concurrent [battles] [fleets_per_battle] [milliseconds_per_run] [max_readers]
+// Every run starts `readers` threads counting fleets in a loop while one writer adds fleets
+// and toggles statuses. "epoch" readers use concurrent_read_lock, "rwlock" readers take a
+// pthread_rwlock the writer holds exclusively. Readers check invariants on every count
+// and the program exits with 1 on the first violation.
+
+#include "galactic_func.h"
+#include "galactic_concurrent.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ADDED_BIT 0x40u            // Only fleets added by the writer carry it
+#define TOGGLED_BIT 0x80u          // Toggled on and back off by one writer batch
+
+struct bench_t {
+  struct galaxy_concurrent_t *concurrent;
+  pthread_rwlock_t rwlock;
+  int use_rwlock;
+  unsigned int battles;
+  unsigned int fleets_per_battle;
+  int stop;                        // Set by the main thread to end a run
+  unsigned long planned_adds;      // Raised by the writer before each add
+  unsigned long writer_ops;
+  int failed;
+};
+
+
+struct reader_arg_t {
+  struct bench_t *bench;
+  unsigned long reads;
+};
+
+
+unsigned long long now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+
+
+// xorshift64, every run draws the same sequence
+unsigned long long next_random(unsigned long long *seed){
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+
+// Writes a deterministic history file, returns 0 on success
+int write_history(const char *fname, unsigned int battles, unsigned int fleets_per_battle){
+  static const char *statuses[] = {"", "|Ready for Jump", "|Shields Active", "|Critical Damage", "|Withdrawal", "|Ready for Jump|Withdrawal"};
+  FILE *file = fopen(fname, "w");
+  if (!file) return 1;
+
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  for (unsigned int b = 0; b < battles; ++b){
+    fprintf(file, "BATTLE:Battle %u\nDATE:%u\n", b, 20000101u + b);
+    for (unsigned int f = 0; f < fleets_per_battle; ++f){
+      unsigned long long r = next_random(&seed);
+      fprintf(file, "FLEET:Fleet %u-%u|0|%llu%s\n", b, f, r % 500, statuses[(r >> 32) % 6]);
+    }
+  }
+  int res = ferror(file);
+  return fclose(file) != 0 || res;
+}
+
+
+void report_failure(struct bench_t *bench, const char *what, long long value, long long bound){
+  if (!__atomic_exchange_n(&bench->failed, 1, __ATOMIC_ACQ_REL))
+    fprintf(stderr, "invariant broken: %s = %lld, bound %lld\n", what, value, bound);
+}
+
+
+void *reader_main(void *ptr){
+  struct reader_arg_t *arg = (struct reader_arg_t *) ptr;
+  struct bench_t *bench = arg->bench;
+
+  struct galaxy_reader_t *reader = NULL;
+  if (concurrent_register_reader(bench->concurrent, &reader) != 0){
+    report_failure(bench, "reader registration", 0, 0);
+    return NULL;
+  }
+
+  long long last_added = 0;
+  unsigned long reads = 0;
+  while (!__atomic_load_n(&bench->stop, __ATOMIC_ACQUIRE)){
+    if (bench->use_rwlock) pthread_rwlock_rdlock(&bench->rwlock);
+    long long added = concurrent_count_fleets_with_status_bits(bench->concurrent, reader, ADDED_BIT);
+    long long toggled = concurrent_count_fleets_with_status_bits(bench->concurrent, reader, TOGGLED_BIT);
+    if (bench->use_rwlock) pthread_rwlock_unlock(&bench->rwlock);
+
+    // Added fleets never disappear, and none is visible before the writer planned it
+    long long planned = (long long) __atomic_load_n(&bench->planned_adds, __ATOMIC_ACQUIRE);
+    if (added < last_added) report_failure(bench, "added fleets went down", added, last_added);
+    if (added > planned) report_failure(bench, "added fleets", added, planned);
+    // Toggles are undone within one batch, a walk can still meet several battles mid-batch
+    long long total = (long long) bench->battles * bench->fleets_per_battle + planned;
+    if (toggled < 0 || toggled > total) report_failure(bench, "toggled fleets", toggled, total);
+
+    last_added = added;
+    reads += 2;
+  }
+
+  concurrent_unregister_reader(bench->concurrent, &reader);
+  arg->reads = reads;
+  return NULL;
+}
+
+
+void *writer_main(void *ptr){
+  struct bench_t *bench = (struct bench_t *) ptr;
+  unsigned long long seed = 0xD1B54A32D192ED03ULL;
+  char name[32];
+  unsigned long ops = 0;
+
+  while (!__atomic_load_n(&bench->stop, __ATOMIC_ACQUIRE)){
+    unsigned int battle = (unsigned int) (next_random(&seed) % bench->battles);
+    snprintf(name, sizeof(name), "Battle %u", battle);
+
+    if (bench->use_rwlock) pthread_rwlock_wrlock(&bench->rwlock);
+    if (ops % 4 == 0){
+      struct fleet_status_t *fleet = (struct fleet_status_t *) malloc(sizeof(struct fleet_status_t));
+      char *fleet_name = strdup("Reinforcements");
+      if (!fleet || !fleet_name){
+        free(fleet);
+        free(fleet_name);
+        report_failure(bench, "writer allocation", 0, 0);
+      }
+      else {
+        fleet->fleet_name = fleet_name;
+        fleet->total_ships = 10;
+        fleet->status_flags = ADDED_BIT;
+        __atomic_add_fetch(&bench->planned_adds, 1, __ATOMIC_RELEASE);
+        if (concurrent_add_fleet_to_battle(bench->concurrent, name, 20000101u + battle, fleet) != 0){
+          free(fleet->fleet_name);
+          free(fleet);
+          report_failure(bench, "add_fleet_to_battle", 0, 0);
+        }
+      }
+    }
+    else {
+      struct fleet_status_command_t commands[2] = {
+        {name, 20000101u + battle, 2, TOGGLED_BIT},
+        {name, 20000101u + battle, 2, TOGGLED_BIT},
+      };
+      int results[2];
+      concurrent_modify_fleet_statuses_batch(bench->concurrent, commands, 2, results);
+    }
+    if (bench->use_rwlock) pthread_rwlock_unlock(&bench->rwlock);
+    ops++;
+  }
+
+  __atomic_store_n(&bench->writer_ops, ops, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+
+// One timed run, returns 0 on success
+int run(struct bench_t *bench, int readers, unsigned int milliseconds){
+  pthread_t threads[GALAXY_MAX_READERS];
+  struct reader_arg_t args[GALAXY_MAX_READERS];
+  pthread_t writer;
+
+  bench->stop = 0;
+  if (pthread_create(&writer, NULL, writer_main, bench) != 0) return 1;
+  int started = 0;
+  for (; started < readers; ++started){
+    args[started].bench = bench;
+    args[started].reads = 0;
+    if (pthread_create(&threads[started], NULL, reader_main, &args[started]) != 0) break;
+  }
+
+  unsigned long long start = now_ns();
+  usleep(milliseconds * 1000u);
+  __atomic_store_n(&bench->stop, 1, __ATOMIC_RELEASE);
+
+  unsigned long reads = 0;
+  for (int i = 0; i < started; ++i){
+    pthread_join(threads[i], NULL);
+    reads += args[i].reads;
+  }
+  pthread_join(writer, NULL);
+  double seconds = (double) (now_ns() - start) / 1e9;
+
+  printf("%-7s readers %2d  reads/s %12.0f  per reader %11.0f  writer ops/s %10.0f\n",
+         bench->use_rwlock ? "rwlock" : "epoch", started, (double) reads / seconds,
+         started ? (double) reads / seconds / started : 0.0, (double) bench->writer_ops / seconds);
+  return started != readers;
+}
+
+
+int main(int argc, char **argv){
+  unsigned int battles = argc > 1 ? (unsigned int) strtoul(argv[1], NULL, 10) : 2000;
+  unsigned int fleets_per_battle = argc > 2 ? (unsigned int) strtoul(argv[2], NULL, 10) : 8;
+  unsigned int milliseconds = argc > 3 ? (unsigned int) strtoul(argv[3], NULL, 10) : 500;
+  int max_readers = argc > 4 ? atoi(argv[4]) : 8;
+  if (!battles || max_readers < 1 || max_readers > GALAXY_MAX_READERS){
+    fprintf(stderr, "usage: %s [battles] [fleets_per_battle] [milliseconds_per_run] [max_readers <= %d]\n", argv[0], GALAXY_MAX_READERS);
+    return 1;
+  }
+
+  char fname[] = "/tmp/galactic_benchXXXXXX";
+  int fd = mkstemp(fname);
+  if (fd < 0) return 2;
+  close(fd);
+  int res = write_history(fname, battles, fleets_per_battle);
+
+  struct galaxy_history_t *history = NULL;
+  if (!res) res = initialize_history(&history);
+  if (!res) res = load_galactic_history(fname, &history);
+  unlink(fname);
+  if (res){
+    fprintf(stderr, "history setup failed: %d\n", res);
+    return res;
+  }
+
+  struct bench_t bench;
+  memset(&bench, 0, sizeof(bench));
+  bench.battles = battles;
+  bench.fleets_per_battle = fleets_per_battle;
+  if (pthread_rwlock_init(&bench.rwlock, NULL) != 0 || concurrent_open(&bench.concurrent, history) != 0){
+    destroy_galactic_history(&history);
+    return 4;
+  }
+
+  printf("%u battles, %u fleets each, %u ms per run\n", battles, fleets_per_battle, milliseconds);
+  for (int readers = 1; readers <= max_readers && !res && !bench.failed; readers *= 2){
+    for (bench.use_rwlock = 0; bench.use_rwlock < 2 && !res; ++bench.use_rwlock) res = run(&bench, readers, milliseconds);
+  }
+
+  concurrent_close(&bench.concurrent);
+  pthread_rwlock_destroy(&bench.rwlock);
+  destroy_galactic_history(&history);
+  return bench.failed || res;
+}
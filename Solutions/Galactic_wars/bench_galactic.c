@@ -0,0 +1,553 @@
+// Microbenchmarks for the galactic_func.h API on generated history files.
+// Build from this directory:
+//   gcc -std=gnu11 -O2 -pthread -o bench_galactic bench_galactic.c $(ls *.c | grep -v -e '^main.c$' -e '^bench')
+// Usage: ./bench_galactic [options]
+//   --battles N        distinct battles in the file (default 20000)
+//   --fleets N         fleets per battle record (default 8)
+//   --dup-rate P       share of battle records repeating an earlier (name, date), merged on load (default 0.05)
+//   --fleet-names N    distinct fleet names the fleets are drawn from (default 1000)
+//   --flag-prob P      probability of each of the 4 status bits (default 0.25)
+//   --seed N           generator seed (default 1)
+//   --runs N           measured runs (default 10)
+//   --warmup N         unmeasured runs before them (default 2)
+//   --ops N            calls per count / modify / add sample (default 10000)
+//   --threads N        threads of the parallel loader (default 4)
+//   --sweep-threads N  also time the parallel loader at 1, 2, 4, ... up to N threads (default: online CPUs, 0 - off)
+//   --append-max N     append k = 10^4, 10^5, ... up to N fleets to one battle (default 1000000, 0 - off)
+//   --data PATH        keep the generated file at PATH instead of a temporary file
+//   --json PATH        write the results as JSON to PATH (default: stdout)
+// Every run loads the file with each loader, times the operations on the fgets-loaded
+// history and destroys it. Each measurement reports min, mean, p50, p90, p99 and max over
+// the runs; load results also report MB/s at the median. The thread sweep reports each
+// parallel load against load_mmap (speedup = load_mmap p50 / load_parallel p50). The append
+// series add k fleets to one battle of a freshly loaded history, one add_fleet_to_battle call
+// per fleet or a single add_fleets_to_battle, and report ns per added fleet (flat in k = linear).
+
+#include "galactic_func.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_RUNS 1000
+#define BENCH_MAX_SWEEP 16
+#define BENCH_MAX_APPEND 8
+#define BENCH_APPEND_MIN 10000u
+
+struct bench_config_t {
+  unsigned int battles;
+  unsigned int fleets;
+  double dup_rate;
+  unsigned int fleet_names;
+  double flag_prob;
+  unsigned long long seed;
+  int runs;
+  int warmup;
+  unsigned int ops;
+  int threads;
+  int sweep_threads;
+  unsigned int append_max;
+  const char *data_path;
+  const char *json_path;
+};
+
+
+// Samples of one measurement, one per measured run
+struct bench_series_t {
+  const char *name;
+  const char *unit;
+  double samples[BENCH_MAX_RUNS];
+  int count;
+  int is_load;                     // Reports MB/s too
+};
+
+
+enum {
+  SERIES_LOAD_FGETS,
+  SERIES_LOAD_MMAP,
+  SERIES_LOAD_PARALLEL,
+  SERIES_LOAD_ARENA,
+  SERIES_COUNT_BIT,
+  SERIES_COUNT_MASK,
+  SERIES_COUNT_RANGE,
+  SERIES_QUERY,
+  SERIES_MODIFY,
+  SERIES_ADD,
+  SERIES_DESTROY,
+  SERIES_DESTROY_ARENA,
+  SERIES_TOTAL
+};
+
+
+double now_ms(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e3 + (double) ts.tv_nsec / 1e6;
+}
+
+
+// xorshift64, the same seed always generates the same file
+unsigned long long next_random(unsigned long long *state){
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+
+// Uniform double in [0, 1)
+double next_unit(unsigned long long *state){
+  return (double) (next_random(state) >> 11) / (double) (1ULL << 53);
+}
+
+
+unsigned int battle_date(unsigned int battle){
+  // Spread over real calendar-looking YYYYMMDD values
+  return 19000101u + (battle / 336u) * 10000u + ((battle / 28u) % 12u) * 100u + battle % 28u;
+}
+
+
+// Writes the history file, returns its size in bytes or 0 on error
+size_t generate_history(const struct bench_config_t *config, const char *path){
+  static const char *const bit_names[4] = {"Ready for Jump", "Shield Active", "Critical Damage", "Withdrawal"};
+  FILE *file = fopen(path, "w");
+  if (!file) return 0;
+
+  unsigned long long state = config->seed ? config->seed : 1;
+  unsigned int written = 0;
+  while (written < config->battles){
+    // Repeated records name an earlier battle, the loader merges their fleets
+    unsigned int battle = written && next_unit(&state) < config->dup_rate ? (unsigned int) (next_random(&state) % written) : written++;
+    fprintf(file, "BATTLE:Battle %u\nDATE:%u\n", battle, battle_date(battle));
+
+    for (unsigned int f = 0; f < config->fleets; ++f){
+      unsigned int name = (unsigned int) (next_random(&state) % config->fleet_names);
+      fprintf(file, "FLEET:Fleet %u|0|%llu", name, next_random(&state) % 1000);
+      for (int bit = 0; bit < 4; ++bit){
+        if (next_unit(&state) < config->flag_prob) fprintf(file, "|%s", bit_names[bit]);
+      }
+      fputc('\n', file);
+    }
+  }
+
+  long size = ftell(file);
+  int failed = ferror(file);
+  if (fclose(file) != 0 || failed || size <= 0) return 0;
+  return (size_t) size;
+}
+
+
+void series_add(struct bench_series_t *series, double value){
+  if (series->count < BENCH_MAX_RUNS) series->samples[series->count++] = value;
+}
+
+
+int compare_doubles(const void *a, const void *b){
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+
+// Nearest-rank percentile of sorted samples
+double percentile(const double *sorted, int count, double p){
+  int rank = (int) (p * count + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > count) rank = count;
+  return sorted[rank - 1];
+}
+
+
+// Loads the file with one loader, returns the elapsed time or a negative value on error
+double timed_load(const char *path, int loader, int threads, struct galaxy_history_t **history){
+  int res = loader == SERIES_LOAD_ARENA ? initialize_history_with_arena(history, 0) : initialize_history(history);
+  if (res) return -1;
+
+  double start = now_ms();
+  if (loader == SERIES_LOAD_MMAP) res = load_galactic_history_mmap(path, history);
+  else if (loader == SERIES_LOAD_PARALLEL) res = load_galactic_history_parallel(path, history, threads);
+  else res = load_galactic_history(path, history);
+  double elapsed = now_ms() - start;
+  return res ? -1 : elapsed;
+}
+
+
+// Thread counts of the sweep: powers of two below `max`, then `max` itself
+int sweep_thread_counts(int max, int *counts){
+  int total = 0;
+  for (int threads = 1; threads < max && total < BENCH_MAX_SWEEP - 1; threads *= 2) counts[total++] = threads;
+  if (max > 0) counts[total++] = max;
+  return total;
+}
+
+
+// One parallel load per sweep thread count
+int run_sweep(const struct bench_config_t *config, const char *path, struct bench_series_t *sweep, int measured){
+  int counts[BENCH_MAX_SWEEP];
+  int total = sweep_thread_counts(config->sweep_threads, counts);
+  struct galaxy_history_t *history = NULL;
+
+  for (int i = 0; i < total; ++i){
+    double elapsed = timed_load(path, SERIES_LOAD_PARALLEL, counts[i], &history);
+    if (elapsed < 0) return 1;
+    if (measured) series_add(&sweep[i], elapsed);
+    destroy_galactic_history(&history);
+  }
+  return 0;
+}
+
+
+// Fleet counts of the append series: 10^4, 10^5, ... up to `max`
+int append_counts(unsigned int max, unsigned int *counts){
+  int total = 0;
+  for (unsigned long long k = BENCH_APPEND_MIN; k <= max && total < BENCH_MAX_APPEND; k *= 10) counts[total++] = (unsigned int) k;
+  return total;
+}
+
+
+// Allocates `count` fleets the way a caller of add_fleet_to_battle does, NULL on error
+struct fleet_status_t **make_fleets(unsigned int count){
+  struct fleet_status_t **fleets = (struct fleet_status_t **) calloc(count, sizeof(struct fleet_status_t *));
+  if (!fleets) return NULL;
+
+  for (unsigned int i = 0; i < count; ++i){
+    fleets[i] = (struct fleet_status_t *) malloc(sizeof(struct fleet_status_t));
+    if (fleets[i]) fleets[i]->fleet_name = strdup("Reinforcements");
+    if (!fleets[i] || !fleets[i]->fleet_name){
+      for (unsigned int k = 0; k <= i; ++k){
+        if (fleets[k]) free(fleets[k]->fleet_name);
+        free(fleets[k]);
+      }
+      free(fleets);
+      return NULL;
+    }
+    fleets[i]->total_ships = i;
+    fleets[i]->status_flags = (unsigned char) (i & 0xF);
+  }
+  return fleets;
+}
+
+
+// Appends k fleets to "Battle 0" for every k of the append series, first one add per fleet,
+// then one bulk add. append[2 * i] and append[2 * i + 1] receive ns per fleet.
+int run_append(const struct bench_config_t *config, const char *path, struct bench_series_t *append, int measured){
+  unsigned int counts[BENCH_MAX_APPEND];
+  int total = append_counts(config->append_max, counts);
+  struct galaxy_history_t *history = NULL;
+  char name[32];
+  snprintf(name, sizeof(name), "Battle %u", 0u);
+
+  for (int i = 0; i < total; ++i){
+    for (int bulk = 0; bulk < 2; ++bulk){
+      unsigned int k = counts[i];
+      struct fleet_status_t **fleets = make_fleets(k);
+      if (!fleets) return 4;
+      if (timed_load(path, SERIES_LOAD_MMAP, 1, &history) < 0){
+        for (unsigned int f = 0; f < k; ++f){
+          free(fleets[f]->fleet_name);
+          free(fleets[f]);
+        }
+        free(fleets);
+        return 1;
+      }
+
+      // The history owns every fleet after a successful add
+      int res = 0;
+      double start = now_ms();
+      if (bulk) res = add_fleets_to_battle(history, name, battle_date(0), fleets, k);
+      else {
+        for (unsigned int f = 0; f < k && !res; ++f) res = add_fleet_to_battle(history, name, battle_date(0), fleets[f]);
+      }
+      double elapsed = now_ms() - start;
+      free(fleets);
+      destroy_galactic_history(&history);
+      if (res) return res;
+      if (measured) series_add(&append[2 * i + bulk], elapsed * 1e6 / k);
+    }
+  }
+  return 0;
+}
+
+
+// One run over every measurement, returns 0 on success
+int run_once(const struct bench_config_t *config, const char *path, struct bench_series_t *series, int measured, unsigned long long *state){
+  static const int loaders[] = {SERIES_LOAD_MMAP, SERIES_LOAD_PARALLEL, SERIES_LOAD_ARENA};
+  struct galaxy_history_t *history = NULL;
+  char name[32];
+
+  for (size_t i = 0; i < sizeof(loaders) / sizeof(loaders[0]); ++i){
+    double elapsed = timed_load(path, loaders[i], config->threads, &history);
+    if (elapsed < 0) return 1;
+    if (measured) series_add(&series[loaders[i]], elapsed);
+
+    if (loaders[i] == SERIES_LOAD_ARENA){
+      double start = now_ms();
+      destroy_galactic_history(&history);
+      if (measured) series_add(&series[SERIES_DESTROY_ARENA], now_ms() - start);
+    }
+    else destroy_galactic_history(&history);
+  }
+
+  double elapsed = timed_load(path, SERIES_LOAD_FGETS, config->threads, &history);
+  if (elapsed < 0) return 1;
+  if (measured) series_add(&series[SERIES_LOAD_FGETS], elapsed);
+
+  // Operations are timed in batches of `ops` calls, a sample is the mean per call in ns
+  volatile long long sink = 0;
+  double start = now_ms();
+  for (unsigned int i = 0; i < config->ops; ++i) sink += count_fleets_with_status_bits(history, 1u << (i & 3));
+  if (measured) series_add(&series[SERIES_COUNT_BIT], (now_ms() - start) * 1e6 / config->ops);
+
+  // Every call toggles a fleet, so the counters answer from a fresh state each time
+  start = now_ms();
+  for (unsigned int i = 0; i < config->ops; ++i){
+    unsigned int battle = (unsigned int) (next_random(state) % config->battles);
+    snprintf(name, sizeof(name), "Battle %u", battle);
+    modify_fleet_statuses_in_battle(history, name, battle_date(battle), 2, 1u << 3);
+    sink += count_fleets_with_status_bits(history, 0x5);
+  }
+  if (measured) series_add(&series[SERIES_COUNT_MASK], (now_ms() - start) * 1e6 / config->ops);
+
+  unsigned int range_ops = config->ops / 100 ? config->ops / 100 : 1;
+  start = now_ms();
+  for (unsigned int i = 0; i < range_ops; ++i){
+    unsigned int from = battle_date((unsigned int) (next_random(state) % config->battles));
+    sink += count_fleets_with_status_bits_in_date_range(history, 0x3, from, from + 10000u);
+  }
+  if (measured) series_add(&series[SERIES_COUNT_RANGE], (now_ms() - start) * 1e6 / range_ops);
+
+  // Ready and not withdrawing, at least 100 ships, over the whole history
+  struct fleet_predicate_t predicate;
+  struct fleet_query_t query;
+  struct fleet_query_result_t found;
+  init_fleet_predicate(&predicate);
+  predicate.all_mask = 1u << 0;
+  predicate.none_mask = 1u << 3;
+  predicate.min_ships = 100;
+  compile_fleet_query(&predicate, &query);
+  start = now_ms();
+  for (unsigned int i = 0; i < range_ops; ++i){
+    run_fleet_query(history, &query, &found, NULL, NULL);
+    sink += (long long) found.ships;
+  }
+  if (measured) series_add(&series[SERIES_QUERY], (now_ms() - start) * 1e6 / range_ops);
+
+  start = now_ms();
+  for (unsigned int i = 0; i < config->ops; ++i){
+    unsigned int battle = (unsigned int) (next_random(state) % config->battles);
+    snprintf(name, sizeof(name), "Battle %u", battle);
+    sink += modify_fleet_statuses_in_battle(history, name, battle_date(battle), (int) (i % 3), 1u << (i & 3));
+  }
+  if (measured) series_add(&series[SERIES_MODIFY], (now_ms() - start) * 1e6 / config->ops);
+
+  // Fleets are prepared before the clock starts, only the insertion is timed
+  struct fleet_status_t **fleets = (struct fleet_status_t **) malloc(config->ops * sizeof(struct fleet_status_t *));
+  if (!fleets){
+    destroy_galactic_history(&history);
+    return 4;
+  }
+  unsigned int ready = 0;
+  for (; ready < config->ops; ++ready){
+    fleets[ready] = (struct fleet_status_t *) malloc(sizeof(struct fleet_status_t));
+    if (!fleets[ready]) break;
+    fleets[ready]->fleet_name = strdup("Reinforcements");
+    fleets[ready]->total_ships = ready;
+    fleets[ready]->status_flags = (unsigned char) (ready & 0xF);
+  }
+  int res = ready == config->ops ? 0 : 4;
+
+  start = now_ms();
+  for (unsigned int i = 0; i < ready; ++i){
+    unsigned int battle = (unsigned int) (next_random(state) % config->battles);
+    snprintf(name, sizeof(name), "Battle %u", battle);
+    if (add_fleet_to_battle(history, name, battle_date(battle), fleets[i]) != 0){
+      free(fleets[i]->fleet_name);
+      free(fleets[i]);
+      res = 2;
+    }
+  }
+  if (measured && !res) series_add(&series[SERIES_ADD], (now_ms() - start) * 1e6 / config->ops);
+  free(fleets);
+
+  start = now_ms();
+  destroy_galactic_history(&history);
+  if (measured) series_add(&series[SERIES_DESTROY], now_ms() - start);
+
+  (void) sink;
+  return res;
+}
+
+
+double series_p50(const struct bench_series_t *s){
+  double sorted[BENCH_MAX_RUNS];
+  memcpy(sorted, s->samples, (size_t) s->count * sizeof(double));
+  qsort(sorted, (size_t) s->count, sizeof(double), compare_doubles);
+  return s->count ? percentile(sorted, s->count, 0.5) : 0;
+}
+
+
+// Statistics of one series as JSON members, without the braces
+void write_series_stats(FILE *out, const struct bench_series_t *s, size_t file_size){
+  double sorted[BENCH_MAX_RUNS];
+  double sum = 0;
+  memcpy(sorted, s->samples, (size_t) s->count * sizeof(double));
+  qsort(sorted, (size_t) s->count, sizeof(double), compare_doubles);
+  for (int k = 0; k < s->count; ++k) sum += sorted[k];
+
+  fprintf(out, "\"name\": \"%s\", \"unit\": \"%s\", \"samples\": %d", s->name, s->unit, s->count);
+  if (s->count){
+    fprintf(out, ", \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f",
+            sorted[0], sum / s->count, percentile(sorted, s->count, 0.5), percentile(sorted, s->count, 0.9),
+            percentile(sorted, s->count, 0.99), sorted[s->count - 1]);
+    if (s->is_load) fprintf(out, ", \"mb_per_s_p50\": %.2f", (double) file_size / 1e6 / (percentile(sorted, s->count, 0.5) / 1e3));
+  }
+}
+
+
+void write_json(FILE *out, const struct bench_config_t *config, size_t file_size, struct bench_series_t *series, struct bench_series_t *sweep, struct bench_series_t *append){
+  fprintf(out, "{\n  \"config\": {\"battles\": %u, \"fleets\": %u, \"dup_rate\": %g, \"fleet_names\": %u, \"flag_prob\": %g, "
+               "\"seed\": %llu, \"runs\": %d, \"warmup\": %d, \"ops\": %u, \"threads\": %d, \"sweep_threads\": %d, \"append_max\": %u, \"file_bytes\": %zu},\n  \"results\": [\n",
+          config->battles, config->fleets, config->dup_rate, config->fleet_names, config->flag_prob,
+          config->seed, config->runs, config->warmup, config->ops, config->threads, config->sweep_threads, config->append_max, file_size);
+
+  for (int i = 0; i < SERIES_TOTAL; ++i){
+    fprintf(out, "    {");
+    write_series_stats(out, &series[i], file_size);
+    fprintf(out, "}%s\n", i + 1 < SERIES_TOTAL ? "," : "");
+  }
+
+  // Speedup curve of the parallel loader, relative to the single-threaded mmap loader
+  int counts[BENCH_MAX_SWEEP];
+  int total = sweep_thread_counts(config->sweep_threads, counts);
+  double mmap_p50 = series_p50(&series[SERIES_LOAD_MMAP]);
+  fprintf(out, "  ],\n  \"thread_sweep\": [\n");
+  for (int i = 0; i < total; ++i){
+    double p50 = series_p50(&sweep[i]);
+    fprintf(out, "    {\"threads\": %d, ", counts[i]);
+    write_series_stats(out, &sweep[i], file_size);
+    fprintf(out, ", \"speedup_vs_mmap_p50\": %.3f}%s\n", p50 > 0 ? mmap_p50 / p50 : 0, i + 1 < total ? "," : "");
+  }
+
+  // Appends to one battle, single then bulk for every k
+  unsigned int sizes[BENCH_MAX_APPEND];
+  int appends = append_counts(config->append_max, sizes);
+  fprintf(out, "  ],\n  \"append_one_battle\": [\n");
+  for (int i = 0; i < 2 * appends; ++i){
+    fprintf(out, "    {\"k\": %u, ", sizes[i / 2]);
+    write_series_stats(out, &append[i], file_size);
+    fprintf(out, "}%s\n", i + 1 < 2 * appends ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+
+int parse_args(int argc, char **argv, struct bench_config_t *config){
+  for (int i = 1; i < argc; ++i){
+    const char *arg = argv[i];
+    if (i + 1 >= argc) return 1;
+    const char *value = argv[++i];
+
+    if (!strcmp(arg, "--battles")) config->battles = (unsigned int) strtoul(value, NULL, 10);
+    else if (!strcmp(arg, "--fleets")) config->fleets = (unsigned int) strtoul(value, NULL, 10);
+    else if (!strcmp(arg, "--dup-rate")) config->dup_rate = strtod(value, NULL);
+    else if (!strcmp(arg, "--fleet-names")) config->fleet_names = (unsigned int) strtoul(value, NULL, 10);
+    else if (!strcmp(arg, "--flag-prob")) config->flag_prob = strtod(value, NULL);
+    else if (!strcmp(arg, "--seed")) config->seed = strtoull(value, NULL, 10);
+    else if (!strcmp(arg, "--runs")) config->runs = atoi(value);
+    else if (!strcmp(arg, "--warmup")) config->warmup = atoi(value);
+    else if (!strcmp(arg, "--ops")) config->ops = (unsigned int) strtoul(value, NULL, 10);
+    else if (!strcmp(arg, "--threads")) config->threads = atoi(value);
+    else if (!strcmp(arg, "--sweep-threads")) config->sweep_threads = atoi(value);
+    else if (!strcmp(arg, "--append-max")) config->append_max = (unsigned int) strtoul(value, NULL, 10);
+    else if (!strcmp(arg, "--data")) config->data_path = value;
+    else if (!strcmp(arg, "--json")) config->json_path = value;
+    else return 1;
+  }
+
+  return !config->battles || !config->fleet_names || !config->ops || config->runs < 1 || config->runs > BENCH_MAX_RUNS
+      || config->warmup < 0 || config->threads < 1 || config->sweep_threads < 0 || config->dup_rate < 0 || config->dup_rate >= 1;
+}
+
+
+int main(int argc, char **argv){
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  struct bench_config_t config = {20000, 8, 0.05, 1000, 0.25, 1, 10, 2, 10000, 4, cpus > 0 ? (int) cpus : 1, 1000000, NULL, NULL};
+  if (parse_args(argc, argv, &config) != 0){
+    fprintf(stderr, "usage: %s [--battles N] [--fleets N] [--dup-rate P] [--fleet-names N] [--flag-prob P] [--seed N]\n"
+                    "          [--runs N] [--warmup N] [--ops N] [--threads N] [--sweep-threads N]\n"
+                    "          [--append-max N] [--data PATH] [--json PATH]\n", argv[0]);
+    return 1;
+  }
+
+  char temp_path[] = "/tmp/galactic_benchXXXXXX";
+  const char *path = config.data_path;
+  if (!path){
+    int fd = mkstemp(temp_path);
+    if (fd < 0) return 2;
+    close(fd);
+    path = temp_path;
+  }
+
+  size_t file_size = generate_history(&config, path);
+  if (!file_size){
+    fprintf(stderr, "cannot write %s\n", path);
+    if (!config.data_path) unlink(temp_path);
+    return 2;
+  }
+
+  static struct bench_series_t series[SERIES_TOTAL] = {
+    [SERIES_LOAD_FGETS] = {"load_fgets", "ms", {0}, 0, 1},
+    [SERIES_LOAD_MMAP] = {"load_mmap", "ms", {0}, 0, 1},
+    [SERIES_LOAD_PARALLEL] = {"load_parallel", "ms", {0}, 0, 1},
+    [SERIES_LOAD_ARENA] = {"load_arena", "ms", {0}, 0, 1},
+    [SERIES_COUNT_BIT] = {"count_single_bit", "ns/call", {0}, 0, 0},
+    [SERIES_COUNT_MASK] = {"toggle_then_count_mask", "ns/call", {0}, 0, 0},
+    [SERIES_COUNT_RANGE] = {"count_date_range", "ns/call", {0}, 0, 0},
+    [SERIES_QUERY] = {"query_predicate", "ns/call", {0}, 0, 0},
+    [SERIES_MODIFY] = {"modify_battle", "ns/call", {0}, 0, 0},
+    [SERIES_ADD] = {"add_fleet", "ns/call", {0}, 0, 0},
+    [SERIES_DESTROY] = {"destroy", "ms", {0}, 0, 0},
+    [SERIES_DESTROY_ARENA] = {"destroy_arena", "ms", {0}, 0, 0},
+  };
+
+  static struct bench_series_t sweep[BENCH_MAX_SWEEP];
+  static char sweep_names[BENCH_MAX_SWEEP][32];
+  int sweep_counts[BENCH_MAX_SWEEP];
+  int sweep_total = sweep_thread_counts(config.sweep_threads, sweep_counts);
+  for (int i = 0; i < sweep_total; ++i){
+    snprintf(sweep_names[i], sizeof(sweep_names[i]), "load_parallel_%dt", sweep_counts[i]);
+    sweep[i].name = sweep_names[i];
+    sweep[i].unit = "ms";
+    sweep[i].is_load = 1;
+  }
+
+  static struct bench_series_t append[2 * BENCH_MAX_APPEND];
+  static char append_names[2 * BENCH_MAX_APPEND][40];
+  unsigned int append_sizes[BENCH_MAX_APPEND];
+  int append_total = append_counts(config.append_max, append_sizes);
+  for (int i = 0; i < 2 * append_total; ++i){
+    snprintf(append_names[i], sizeof(append_names[i]), "%s_k%u", i % 2 ? "add_fleets_bulk" : "add_fleet_single", append_sizes[i / 2]);
+    append[i].name = append_names[i];
+    append[i].unit = "ns/fleet";
+  }
+
+  // The operation sequence depends only on the seed, not on the run
+  int res = 0;
+  for (int run = 0; run < config.warmup + config.runs && !res; ++run){
+    unsigned long long state = (config.seed ? config.seed : 1) * 0x9E3779B97F4A7C15ULL;
+    res = run_once(&config, path, series, run >= config.warmup, &state);
+    if (!res) res = run_sweep(&config, path, sweep, run >= config.warmup);
+    if (!res) res = run_append(&config, path, append, run >= config.warmup);
+  }
+  if (!config.data_path) unlink(temp_path);
+  if (res){
+    fprintf(stderr, "benchmark run failed: %d\n", res);
+    return res;
+  }
+
+  FILE *out = config.json_path ? fopen(config.json_path, "w") : stdout;
+  if (!out) return 2;
+  write_json(out, &config, file_size, series, sweep, append);
+  if (out != stdout && fclose(out) != 0) return 2;
+  return 0;
+}
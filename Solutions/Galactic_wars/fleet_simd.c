@@ -0,0 +1,154 @@
+#include "fleet_simd.h"
+
+#ifdef FLEET_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+size_t fleet_flags_count_any_scalar(const unsigned char *flags, size_t count, unsigned char mask){
+  size_t matches = 0;
+  for (size_t i = 0; i < count; ++i) matches += (flags[i] & mask) != 0;
+  return matches;
+}
+
+
+int fleet_flags_apply_scalar(unsigned char *flags, size_t count, int operation_type, unsigned char mask){
+  switch (operation_type){
+    case 0:
+      for (size_t i = 0; i < count; ++i) flags[i] |= mask;
+      break;
+    case 1:
+      for (size_t i = 0; i < count; ++i) flags[i] &= (unsigned char) ~mask;
+      break;
+    case 2:
+      for (size_t i = 0; i < count; ++i) flags[i] ^= mask;
+      break;
+    default:
+      return 1;
+  }
+  return 0;
+}
+
+
+#ifdef FLEET_SIMD_X86
+
+// SSE2 kernels, 16 flags per step
+__attribute__((target("sse2")))
+size_t fleet_flags_count_any_sse2(const unsigned char *flags, size_t count, unsigned char mask){
+  const __m128i maskv = _mm_set1_epi8((char) mask);
+  const __m128i zero = _mm_setzero_si128();
+  size_t matches = 0;
+  size_t i = 0;
+
+  // Bytes with no mask bit compare equal to zero, the rest are matches
+  for ( ; i + 16 <= count; i += 16){
+    __m128i v = _mm_loadu_si128((const __m128i *) (flags + i));
+    unsigned int none = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, maskv), zero));
+    matches += 16 - (size_t) __builtin_popcount(none);
+  }
+  return matches + fleet_flags_count_any_scalar(flags + i, count - i, mask);
+}
+
+
+__attribute__((target("sse2")))
+void fleet_flags_apply_sse2(unsigned char *flags, size_t count, int operation_type, unsigned char mask){
+  const __m128i maskv = _mm_set1_epi8((char) mask);
+  size_t i = 0;
+
+  for ( ; i + 16 <= count; i += 16){
+    __m128i v = _mm_loadu_si128((const __m128i *) (flags + i));
+    if (operation_type == 0) v = _mm_or_si128(v, maskv);
+    else if (operation_type == 1) v = _mm_andnot_si128(maskv, v);
+    else v = _mm_xor_si128(v, maskv);
+    _mm_storeu_si128((__m128i *) (flags + i), v);
+  }
+  fleet_flags_apply_scalar(flags + i, count - i, operation_type, mask);
+}
+
+
+// AVX2 kernels, 32 flags per step
+__attribute__((target("avx2,popcnt")))
+size_t fleet_flags_count_any_avx2(const unsigned char *flags, size_t count, unsigned char mask){
+  const __m256i maskv = _mm256_set1_epi8((char) mask);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t matches = 0;
+  size_t i = 0;
+
+  // Two vectors per step so the popcounts of both masks overlap
+  for ( ; i + 64 <= count; i += 64){
+    __m256i a = _mm256_loadu_si256((const __m256i *) (flags + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *) (flags + i + 32));
+    unsigned int none_a = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(a, maskv), zero));
+    unsigned int none_b = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(b, maskv), zero));
+    matches += 64 - (size_t) (__builtin_popcount(none_a) + __builtin_popcount(none_b));
+  }
+  for ( ; i + 32 <= count; i += 32){
+    __m256i v = _mm256_loadu_si256((const __m256i *) (flags + i));
+    unsigned int none = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(v, maskv), zero));
+    matches += 32 - (size_t) __builtin_popcount(none);
+  }
+  return matches + fleet_flags_count_any_scalar(flags + i, count - i, mask);
+}
+
+
+__attribute__((target("avx2")))
+void fleet_flags_apply_avx2(unsigned char *flags, size_t count, int operation_type, unsigned char mask){
+  const __m256i maskv = _mm256_set1_epi8((char) mask);
+  size_t i = 0;
+
+  for ( ; i + 32 <= count; i += 32){
+    __m256i v = _mm256_loadu_si256((const __m256i *) (flags + i));
+    if (operation_type == 0) v = _mm256_or_si256(v, maskv);
+    else if (operation_type == 1) v = _mm256_andnot_si256(maskv, v);
+    else v = _mm256_xor_si256(v, maskv);
+    _mm256_storeu_si256((__m256i *) (flags + i), v);
+  }
+  fleet_flags_apply_scalar(flags + i, count - i, operation_type, mask);
+}
+
+
+// Level fleet_simd_detect found, -1 - not probed yet
+int fleet_simd_level = -1;
+
+int fleet_simd_detect(void){
+  int level = __atomic_load_n(&fleet_simd_level, __ATOMIC_RELAXED);
+  if (level >= 0) return level;
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) level = 2;
+  else if (__builtin_cpu_supports("sse2")) level = 1;
+  else level = 0;
+
+  __atomic_store_n(&fleet_simd_level, level, __ATOMIC_RELAXED);
+  return level;
+}
+
+#endif // FLEET_SIMD_X86
+
+
+size_t fleet_flags_count_any(const unsigned char *flags, size_t count, unsigned char mask){
+  if (!mask || !count) return 0;
+
+#ifdef FLEET_SIMD_X86
+  switch (fleet_simd_detect()){
+    case 2: return fleet_flags_count_any_avx2(flags, count, mask);
+    case 1: return fleet_flags_count_any_sse2(flags, count, mask);
+    default: break;
+  }
+#endif
+  return fleet_flags_count_any_scalar(flags, count, mask);
+}
+
+
+int fleet_flags_apply(unsigned char *flags, size_t count, int operation_type, unsigned char mask){
+  if (operation_type < 0 || operation_type > 2) return 1;
+
+#ifdef FLEET_SIMD_X86
+  switch (fleet_simd_detect()){
+    case 2: fleet_flags_apply_avx2(flags, count, operation_type, mask); return 0;
+    case 1: fleet_flags_apply_sse2(flags, count, operation_type, mask); return 0;
+    default: break;
+  }
+#endif
+  return fleet_flags_apply_scalar(flags, count, operation_type, mask);
+}
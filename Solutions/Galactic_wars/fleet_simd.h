@@ -0,0 +1,33 @@
+#ifndef FLEET_SIMD_H
+#define FLEET_SIMD_H
+#include <stddef.h>
+
+// Kernels over packed status_flags bytes (see struct fleet_store_t).
+// The dispatching versions pick AVX2, SSE2 or the scalar loop at runtime,
+// all of them give bit for bit the same results as the scalar loop.
+
+// Counts bytes with at least one of the `mask` bits set.
+size_t fleet_flags_count_any(const unsigned char *flags, size_t count, unsigned char mask);
+
+// Applies `operation_type` to every byte: 0 - set bits (OR), 1 - clear bits (AND NOT), 2 - toggle bits (XOR).
+// Returns 0 on success, 1 on unknown operation type (flags are unchanged then).
+int fleet_flags_apply(unsigned char *flags, size_t count, int operation_type, unsigned char mask);
+
+// Scalar reference versions, also used for tails and on CPUs without SIMD.
+size_t fleet_flags_count_any_scalar(const unsigned char *flags, size_t count, unsigned char mask);
+int fleet_flags_apply_scalar(unsigned char *flags, size_t count, int operation_type, unsigned char mask);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FLEET_SIMD_X86 1
+
+// Instruction set of this CPU the dispatching versions use: 0 - scalar, 1 - SSE2, 2 - AVX2.
+int fleet_simd_detect(void);
+
+// Fixed-width versions, callable only when fleet_simd_detect() reports their level.
+size_t fleet_flags_count_any_sse2(const unsigned char *flags, size_t count, unsigned char mask);
+void fleet_flags_apply_sse2(unsigned char *flags, size_t count, int operation_type, unsigned char mask);
+size_t fleet_flags_count_any_avx2(const unsigned char *flags, size_t count, unsigned char mask);
+void fleet_flags_apply_avx2(unsigned char *flags, size_t count, int operation_type, unsigned char mask);
+#endif
+
+#endif //FLEET_SIMD_H
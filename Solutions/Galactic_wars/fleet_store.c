@@ -0,0 +1,177 @@
+#include "fleet_store.h"
+#include "fleet_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+void fleet_store_init(struct fleet_store_t *store){
+  store->status_flags = NULL;
+  store->total_ships = NULL;
+  store->battle_ids = NULL;
+  store->size = 0;
+  store->capacity = 0;
+  memset(store->flag_histogram, 0, sizeof(store->flag_histogram));
+  memset(store->bit_counts, 0, sizeof(store->bit_counts));
+  memset(store->mask_counts, 0, sizeof(store->mask_counts));
+  memset(store->mask_cached_at, 0, sizeof(store->mask_cached_at));
+  store->generation = 1;
+  store->stats = NULL;
+}
+
+
+void fleet_store_free(struct fleet_store_t *store){
+  free(store->status_flags);
+  free(store->total_ships);
+  free(store->battle_ids);
+  fleet_store_init(store);
+}
+
+
+// Grows every column to hold at least `needed` slots
+// Returns 0 on success, 4 on memory allocation error
+int fleet_store_grow(struct fleet_store_t *store, size_t needed){
+  if (needed <= store->capacity) return 0;
+
+  size_t capacity = store->capacity ? store->capacity : 64;
+  while (capacity < needed) capacity *= 2;
+
+  // Columns are swapped in one by one, capacity is only raised once all of them grew
+  unsigned char *flags = (unsigned char *) realloc(store->status_flags, capacity * sizeof(unsigned char));
+  if (!flags) return 4;
+  store->status_flags = flags;
+
+  unsigned int *ships = (unsigned int *) realloc(store->total_ships, capacity * sizeof(unsigned int));
+  if (!ships) return 4;
+  store->total_ships = ships;
+
+  unsigned int *ids = (unsigned int *) realloc(store->battle_ids, capacity * sizeof(unsigned int));
+  if (!ids) return 4;
+  store->battle_ids = ids;
+
+  store->capacity = capacity;
+  if (store->stats){
+    store->stats->reallocs += 3;
+    store->stats->bytes_allocated += capacity * (sizeof(unsigned char) + 2 * sizeof(unsigned int));
+  }
+  return 0;
+}
+
+
+// Turns slots [from, to) into holes
+void fleet_store_clear(struct fleet_store_t *store, size_t from, size_t to){
+  memset(store->status_flags + from, 0, (to - from) * sizeof(unsigned char));
+  memset(store->total_ships + from, 0, (to - from) * sizeof(unsigned int));
+  for (size_t i = from; i < to; ++i) store->battle_ids[i] = FLEET_STORE_HOLE;
+}
+
+
+int fleet_store_reserve(struct fleet_store_t *store, struct battle_t *battle, size_t needed){
+  if (needed <= battle->store_capacity) return 0;
+
+  size_t capacity = battle->store_capacity ? battle->store_capacity * 2 : 4;
+  while (capacity < needed) capacity *= 2;
+
+  // Last segment grows in place
+  if (battle->store_capacity && battle->store_offset + battle->store_capacity == store->size){
+    if (fleet_store_grow(store, battle->store_offset + capacity) != 0) return 4;
+
+    fleet_store_clear(store, store->size, battle->store_offset + capacity);
+    store->size = battle->store_offset + capacity;
+    battle->store_capacity = capacity;
+    return 0;
+  }
+
+  // Any other segment moves to the end, leaving holes behind
+  size_t offset = store->size;
+  if (fleet_store_grow(store, offset + capacity) != 0) return 4;
+
+  fleet_store_clear(store, offset, offset + capacity);
+  if (battle->store_capacity){
+    size_t used = battle->num_fleets;
+    memcpy(store->status_flags + offset, store->status_flags + battle->store_offset, used * sizeof(unsigned char));
+    memcpy(store->total_ships + offset, store->total_ships + battle->store_offset, used * sizeof(unsigned int));
+    memcpy(store->battle_ids + offset, store->battle_ids + battle->store_offset, used * sizeof(unsigned int));
+    fleet_store_clear(store, battle->store_offset, battle->store_offset + battle->store_capacity);
+  }
+  store->size = offset + capacity;
+  battle->store_offset = offset;
+  battle->store_capacity = capacity;
+  return 0;
+}
+
+
+void fleet_store_set(struct fleet_store_t *store, const struct battle_t *battle, size_t index, unsigned char status_flags, unsigned int total_ships){
+  size_t slot = battle->store_offset + index;
+  store->status_flags[slot] = status_flags;
+  store->total_ships[slot] = total_ships;
+  store->battle_ids[slot] = battle->battle_id;
+
+  store->flag_histogram[status_flags]++;
+  for (int bit = 0; bit < 8; ++bit) store->bit_counts[bit] += (status_flags >> bit) & 1u;
+  store->generation++;
+}
+
+
+void fleet_store_release(struct fleet_store_t *store, struct battle_t *battle){
+  for (size_t i = 0; i < battle->num_fleets; ++i){
+    unsigned char status_flags = store->status_flags[battle->store_offset + i];
+    store->flag_histogram[status_flags]--;
+    for (int bit = 0; bit < 8; ++bit) store->bit_counts[bit] -= (status_flags >> bit) & 1u;
+  }
+  if (battle->store_capacity) fleet_store_clear(store, battle->store_offset, battle->store_offset + battle->store_capacity);
+
+  battle->store_offset = 0;
+  battle->store_capacity = 0;
+  store->generation++;
+}
+
+
+void fleet_store_recount(struct fleet_store_t *store, unsigned char old_flags, unsigned char new_flags){
+  if (old_flags == new_flags) return;
+
+  store->flag_histogram[old_flags]--;
+  store->flag_histogram[new_flags]++;
+  for (int bit = 0; bit < 8; ++bit){
+    store->bit_counts[bit] += ((new_flags >> bit) & 1u);
+    store->bit_counts[bit] -= ((old_flags >> bit) & 1u);
+  }
+  store->generation++;
+}
+
+
+size_t fleet_store_cached_count(struct fleet_store_t *store, unsigned char mask){
+  if (!mask) return 0;
+
+  // Single bit is a counter of its own
+  if (!(mask & (mask - 1))) return store->bit_counts[__builtin_ctz(mask)];
+
+  // Callers that only read may race on the cache entry. For one generation all of them write
+  // the same count, and the count is published before its generation.
+  if (__atomic_load_n(&store->mask_cached_at[mask], __ATOMIC_ACQUIRE) == store->generation){
+    return __atomic_load_n(&store->mask_counts[mask], __ATOMIC_RELAXED);
+  }
+
+  size_t count = 0;
+  for (unsigned int value = 1; value < 256; ++value){
+    if (value & mask) count += store->flag_histogram[value];
+  }
+  __atomic_store_n(&store->mask_counts[mask], count, __ATOMIC_RELAXED);
+  __atomic_store_n(&store->mask_cached_at[mask], store->generation, __ATOMIC_RELEASE);
+  return count;
+}
+
+
+size_t fleet_store_count_flags(const struct fleet_store_t *store, unsigned char mask){
+  return fleet_flags_count_any(store->status_flags, store->size, mask);
+}
+
+
+unsigned long long fleet_store_sum_ships(const struct fleet_store_t *store, unsigned char mask){
+  unsigned long long sum = 0;
+  const unsigned char *flags = store->status_flags;
+  const unsigned int *ships = store->total_ships;
+  for (size_t i = 0; i < store->size; ++i){
+    if (flags[i] & mask) sum += ships[i];
+  }
+  return sum;
+}
@@ -0,0 +1,38 @@
+#ifndef FLEET_STORE_H
+#define FLEET_STORE_H
+#include "galactic_func.h"
+#include <stddef.h>
+
+// Functions maintaining struct fleet_store_t (see galactic_func.h).
+
+// Prepares an empty store, its column growth is not counted until `stats` is set.
+void fleet_store_init(struct fleet_store_t *store);
+
+// Frees the columns, the store is empty afterwards.
+void fleet_store_free(struct fleet_store_t *store);
+
+// Makes sure `battle` owns at least `needed` slots. A segment at the end of the store grows
+// in place, any other segment is moved to the end and its old slots become holes.
+// Returns 0 on success, 4 on memory allocation error (battle and store are unchanged then).
+int fleet_store_reserve(struct fleet_store_t *store, struct battle_t *battle, size_t needed);
+
+// Writes new fleet `index` of `battle` into its slot (the slot must be reserved) and counts it.
+void fleet_store_set(struct fleet_store_t *store, const struct battle_t *battle, size_t index, unsigned char status_flags, unsigned int total_ships);
+
+// Uncounts the fleets of `battle` and turns its whole segment into holes (battle keeps no slots).
+void fleet_store_release(struct fleet_store_t *store, struct battle_t *battle);
+
+// Moves one fleet from `old_flags` to `new_flags` in the counters.
+void fleet_store_recount(struct fleet_store_t *store, unsigned char old_flags, unsigned char new_flags);
+
+// Counts fleets with at least one of the `mask` bits set from the counters. Refreshes the
+// mask cache, which is safe from several threads as long as none of them changes the store.
+size_t fleet_store_cached_count(struct fleet_store_t *store, unsigned char mask);
+
+// Counts slots with at least one of the `mask` bits set.
+size_t fleet_store_count_flags(const struct fleet_store_t *store, unsigned char mask);
+
+// Sums total_ships over slots with at least one of the `mask` bits set.
+unsigned long long fleet_store_sum_ships(const struct fleet_store_t *store, unsigned char mask);
+
+#endif //FLEET_STORE_H
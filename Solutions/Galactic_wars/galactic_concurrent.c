@@ -0,0 +1,233 @@
+#include "galactic_concurrent.h"
+#include "galactic_internal.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Epoch-based reclamation: a reader announces the global epoch it entered in, a writer
+// advances the epoch only when every reader inside a read section announced the current
+// one. A block retired in epoch e is unreachable for readers entering later, and after two
+// advances no reader from epoch e or before is left, so retired[e % 3] is freed then.
+
+
+// Frees the blocks of one retired list
+void retired_list_free(struct retired_list_t *list){
+  for (size_t i = 0; i < list->count; ++i) free(list->ptrs[i]);
+  list->count = 0;
+}
+
+
+// Advances the global epoch if every active reader is in the current one (writer lock held)
+// Returns 1 if the epoch moved, 0 if a reader still lags behind
+int concurrent_try_advance(struct galaxy_concurrent_t *concurrent){
+  unsigned long epoch = concurrent->epoch;
+
+  // Pairs with the fence of concurrent_read_lock: a reader not seen here sees every
+  // unpublishing store made before
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  for (int i = 0; i < GALAXY_MAX_READERS; ++i){
+    struct galaxy_reader_t *reader = concurrent->readers[i];
+    if (!reader) continue;
+
+    unsigned long state = __atomic_load_n(&reader->state, __ATOMIC_ACQUIRE);
+    if ((state & 1) && (state >> 1) != epoch) return 0;
+  }
+
+  __atomic_store_n(&concurrent->epoch, epoch + 1, __ATOMIC_RELEASE);
+  // Blocks retired in epoch - 1 are out of reach now
+  retired_list_free(&concurrent->retired[(epoch + 2) % 3]);
+  return 1;
+}
+
+
+// Retire hook installed into the history (writer lock held)
+void concurrent_retire(void *ctx, void *ptr){
+  struct galaxy_concurrent_t *concurrent = (struct galaxy_concurrent_t *) ctx;
+  struct retired_list_t *list = &concurrent->retired[concurrent->epoch % 3];
+
+  if (list->count == list->capacity){
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    void **resized = (void **) realloc(list->ptrs, capacity * sizeof(void *));
+    if (!resized){
+      // Nowhere to park the block, wait out the readers and free it right away
+      unsigned long target = concurrent->epoch + 2;
+      while (concurrent->epoch != target){
+        if (!concurrent_try_advance(concurrent)) sched_yield();
+      }
+      free(ptr);
+      return;
+    }
+    list->ptrs = resized;
+    list->capacity = capacity;
+  }
+  list->ptrs[list->count++] = ptr;
+}
+
+
+// Returns 0 on success, 1 on invalid input, 4 on memory allocation error.
+int concurrent_open(struct galaxy_concurrent_t **concurrent_ptr, struct galaxy_history_t *history){
+  if (!concurrent_ptr || !history || history->retire) return 1;
+
+  struct galaxy_concurrent_t *concurrent = (struct galaxy_concurrent_t *) calloc(1, sizeof(struct galaxy_concurrent_t));
+  if (!concurrent) return 4;
+  if (pthread_mutex_init(&concurrent->writer_lock, NULL) != 0){
+    free(concurrent);
+    return 4;
+  }
+
+  concurrent->history = history;
+  concurrent->epoch = 1;
+  history->retire_ctx = concurrent;
+  history->retire = concurrent_retire;
+  *concurrent_ptr = concurrent;
+  return 0;
+}
+
+
+void concurrent_close(struct galaxy_concurrent_t **concurrent_ptr){
+  if (!concurrent_ptr || !*concurrent_ptr) return;
+
+  struct galaxy_concurrent_t *concurrent = *concurrent_ptr;
+  for (int i = 0; i < 3; ++i){
+    retired_list_free(&concurrent->retired[i]);
+    free(concurrent->retired[i].ptrs);
+  }
+  for (int i = 0; i < GALAXY_MAX_READERS; ++i) free(concurrent->readers[i]);
+
+  concurrent->history->retire = NULL;
+  concurrent->history->retire_ctx = NULL;
+  pthread_mutex_destroy(&concurrent->writer_lock);
+  free(concurrent);
+  *concurrent_ptr = NULL;
+}
+
+
+// Returns 0 on success, 1 on invalid input, 4 on memory allocation error, 5 if all slots are taken.
+int concurrent_register_reader(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t **reader_ptr){
+  if (!concurrent || !reader_ptr) return 1;
+
+  struct galaxy_reader_t *reader = (struct galaxy_reader_t *) aligned_alloc(64, sizeof(struct galaxy_reader_t));
+  if (!reader) return 4;
+  memset(reader, 0, sizeof(struct galaxy_reader_t));
+
+  pthread_mutex_lock(&concurrent->writer_lock);
+  int slot = 0;
+  while (slot < GALAXY_MAX_READERS && concurrent->readers[slot]) slot++;
+  if (slot < GALAXY_MAX_READERS){
+    reader->slot = slot;
+    concurrent->readers[slot] = reader;
+  }
+  pthread_mutex_unlock(&concurrent->writer_lock);
+
+  if (slot == GALAXY_MAX_READERS){
+    free(reader);
+    return 5;
+  }
+  *reader_ptr = reader;
+  return 0;
+}
+
+
+void concurrent_unregister_reader(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t **reader_ptr){
+  if (!concurrent || !reader_ptr || !*reader_ptr) return;
+
+  pthread_mutex_lock(&concurrent->writer_lock);
+  concurrent->readers[(*reader_ptr)->slot] = NULL;
+  pthread_mutex_unlock(&concurrent->writer_lock);
+
+  free(*reader_ptr);
+  *reader_ptr = NULL;
+}
+
+
+void concurrent_read_lock(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t *reader){
+  unsigned long epoch = __atomic_load_n(&concurrent->epoch, __ATOMIC_ACQUIRE);
+  __atomic_store_n(&reader->state, (epoch << 1) | 1, __ATOMIC_RELAXED);
+  // The announcement must be visible before any shared pointer is loaded
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+
+void concurrent_read_unlock(struct galaxy_reader_t *reader){
+  __atomic_store_n(&reader->state, 0, __ATOMIC_RELEASE);
+}
+
+
+// Returns: The count of fleets meeting the criteria, -1 on error (e.g., NULL concurrent).
+int concurrent_count_fleets_with_status_bits(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t *reader, unsigned int mask){
+  if (!concurrent || !reader) return -1;
+
+  unsigned char bits = (unsigned char) mask;
+  int count = 0;
+
+  concurrent_read_lock(concurrent, reader);
+  struct battle_node_t *current = __atomic_load_n(&concurrent->history->head, __ATOMIC_ACQUIRE);
+  while (current){
+    struct battle_t *battle = current->battle;
+    size_t num_fleets = __atomic_load_n(&battle->num_fleets, __ATOMIC_ACQUIRE);
+    struct fleet_status_t **fleets = __atomic_load_n(&battle->fleet_statuses, __ATOMIC_ACQUIRE);
+
+    for (size_t i = 0; i < num_fleets; ++i){
+      if (__atomic_load_n(&fleets[i]->status_flags, __ATOMIC_RELAXED) & bits) count++;
+    }
+    current = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
+  }
+  concurrent_read_unlock(reader);
+
+  return count;
+}
+
+
+void concurrent_display_galactic_history(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t *reader){
+  if (!concurrent || !reader) return;
+
+  concurrent_read_lock(concurrent, reader);
+  display_galactic_history(concurrent->history);
+  concurrent_read_unlock(reader);
+}
+
+
+// Returns: 0 on success, 1 on invalid input, 2 - battle not found, 4 - memory allocation failure
+int concurrent_add_fleet_to_battle(struct galaxy_concurrent_t *concurrent, const char *battle_name, unsigned int date, struct fleet_status_t *new_fleet){
+  if (!concurrent) return 1;
+
+  pthread_mutex_lock(&concurrent->writer_lock);
+  int res = add_fleet_to_battle(concurrent->history, battle_name, date, new_fleet);
+  concurrent_try_advance(concurrent);
+  pthread_mutex_unlock(&concurrent->writer_lock);
+  return res;
+}
+
+
+// Returns: 0 on success, 1 on invalid input, 2 - battle not found, 4 - memory allocation failure
+int concurrent_add_fleets_to_battle(struct galaxy_concurrent_t *concurrent, const char *battle_name, unsigned int date, struct fleet_status_t **fleets, size_t count){
+  if (!concurrent) return 1;
+
+  pthread_mutex_lock(&concurrent->writer_lock);
+  int res = add_fleets_to_battle(concurrent->history, battle_name, date, fleets, count);
+  concurrent_try_advance(concurrent);
+  pthread_mutex_unlock(&concurrent->writer_lock);
+  return res;
+}
+
+
+// Returns: The number of fleets modified, -1 if battle not found or on error.
+int concurrent_modify_fleet_statuses_in_battle(struct galaxy_concurrent_t *concurrent, const char *battle_name, unsigned int date, int operation_type, unsigned int mask){
+  if (!concurrent) return -1;
+
+  pthread_mutex_lock(&concurrent->writer_lock);
+  int res = modify_fleet_statuses_in_battle(concurrent->history, battle_name, date, operation_type, mask);
+  pthread_mutex_unlock(&concurrent->writer_lock);
+  return res;
+}
+
+
+// Returns: The number of commands applied, -1 on invalid input.
+int concurrent_modify_fleet_statuses_batch(struct galaxy_concurrent_t *concurrent, const struct fleet_status_command_t *commands, size_t count, int *results){
+  if (!concurrent) return -1;
+
+  pthread_mutex_lock(&concurrent->writer_lock);
+  int res = modify_fleet_statuses_batch(concurrent->history, commands, count, results);
+  pthread_mutex_unlock(&concurrent->writer_lock);
+  return res;
+}
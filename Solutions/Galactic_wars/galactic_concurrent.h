@@ -0,0 +1,78 @@
+#ifndef GALACTIC_CONCURRENT_H
+#define GALACTIC_CONCURRENT_H
+#include "galactic_func.h"
+#include <pthread.h>
+#include <stddef.h>
+
+// Concurrent access to one galaxy_history_t: many reader threads count and display while
+// one writer at a time adds fleets and changes statuses. Writers are serialized by a mutex,
+// readers never take it. Blocks a writer replaces are published with release stores and
+// retired instead of freed, they are freed once every reader that could still see them has
+// left its read section (epoch-based reclamation).
+
+#define GALAXY_MAX_READERS 64
+
+// Per-thread reader record, one cache line so readers do not share lines.
+struct galaxy_reader_t {
+  unsigned long state;             // (epoch << 1) | 1 inside a read section, 0 outside.
+  int slot;                        // Index in galaxy_concurrent_t.readers.
+  char padding[64 - sizeof(unsigned long) - sizeof(int)];
+};
+
+
+// Blocks retired during one epoch.
+struct retired_list_t {
+  void **ptrs;
+  size_t count;
+  size_t capacity;
+};
+
+
+struct galaxy_concurrent_t {
+  struct galaxy_history_t *history;    // Shared history, still owned by the caller.
+  pthread_mutex_t writer_lock;         // Serializes writers and reader registration.
+  unsigned long epoch;                 // Global epoch, only advanced by writers.
+  struct galaxy_reader_t *readers[GALAXY_MAX_READERS]; // Registered readers, NULL slots are free.
+  struct retired_list_t retired[3];    // Blocks retired in epoch e wait in retired[e % 3].
+};
+
+
+// Makes `history` shareable. Until concurrent_close the history must only be changed
+// through the concurrent_* writer functions.
+// Returns 0 on success, 1 on invalid input, 4 on memory allocation error.
+int concurrent_open(struct galaxy_concurrent_t **concurrent_ptr, struct galaxy_history_t *history);
+
+// Frees every retired block and detaches the history, which stays valid for the caller.
+// No reader may be inside a read section anymore.
+void concurrent_close(struct galaxy_concurrent_t **concurrent_ptr);
+
+// Registers the calling thread as a reader.
+// Returns 0 on success, 1 on invalid input, 4 on memory allocation error, 5 if all
+// GALAXY_MAX_READERS slots are taken.
+int concurrent_register_reader(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t **reader_ptr);
+
+// Releases a reader record, the reader must be outside its read section.
+void concurrent_unregister_reader(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t **reader_ptr);
+
+// Read sections: battles, fleet arrays and fleets seen in between stay valid. Sections do not
+// nest and never wait for writers.
+void concurrent_read_lock(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t *reader);
+void concurrent_read_unlock(struct galaxy_reader_t *reader);
+
+// count_fleets_with_status_bits for readers. The counters of the fleet store belong to the
+// writer, so the fleets are walked instead; each fleet is seen either before or after a
+// concurrent status change, never torn.
+// Returns: The count of fleets meeting the criteria, -1 on error (e.g., NULL concurrent).
+int concurrent_count_fleets_with_status_bits(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t *reader, unsigned int mask);
+
+// display_galactic_history for readers.
+void concurrent_display_galactic_history(struct galaxy_concurrent_t *concurrent, struct galaxy_reader_t *reader);
+
+// Writer versions of add_fleet_to_battle, add_fleets_to_battle, modify_fleet_statuses_in_battle
+// and modify_fleet_statuses_batch, same arguments and return values.
+int concurrent_add_fleet_to_battle(struct galaxy_concurrent_t *concurrent, const char *battle_name, unsigned int date, struct fleet_status_t *new_fleet);
+int concurrent_add_fleets_to_battle(struct galaxy_concurrent_t *concurrent, const char *battle_name, unsigned int date, struct fleet_status_t **fleets, size_t count);
+int concurrent_modify_fleet_statuses_in_battle(struct galaxy_concurrent_t *concurrent, const char *battle_name, unsigned int date, int operation_type, unsigned int mask);
+int concurrent_modify_fleet_statuses_batch(struct galaxy_concurrent_t *concurrent, const struct fleet_status_command_t *commands, size_t count, int *results);
+
+#endif //GALACTIC_CONCURRENT_H
@@ -0,0 +1,135 @@
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include "fleet_simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Date-ordered index over the battles. New battles are appended unsorted and the tail is
+// sorted and merged into the sorted prefix by the next range query, so loading stays
+// linear and queries pay O(log N + k) once the index is settled.
+
+
+// Appends a new battle to the unsorted tail
+// Returns 0 on success, 4 on memory allocation error
+int date_index_append(struct galaxy_history_t *history, struct battle_node_t *node){
+  if (history->date_index_count == history->date_index_capacity){
+    size_t capacity = history->date_index_capacity ? history->date_index_capacity * 2 : 16;
+    struct battle_node_t **resized = (struct battle_node_t **) realloc(history->date_index, capacity * sizeof(struct battle_node_t *));
+    if (!resized) return 4;
+    STATS_ADD(history, reallocs, 1);
+    STATS_ADD(history, bytes_allocated, capacity * sizeof(struct battle_node_t *));
+
+    history->date_index = resized;
+    history->date_index_capacity = capacity;
+  }
+  history->date_index[history->date_index_count++] = node;
+  return 0;
+}
+
+
+void date_index_remove(struct galaxy_history_t *history, struct battle_node_t *node){
+  // Usually the battle just added, so the search starts at the end
+  size_t pos = history->date_index_count;
+  while (pos && history->date_index[pos - 1] != node) pos--;
+  if (!pos) return;
+  pos--;
+
+  memmove(history->date_index + pos, history->date_index + pos + 1, (history->date_index_count - pos - 1) * sizeof(struct battle_node_t *));
+  history->date_index_count--;
+  if (pos < history->date_index_sorted) history->date_index_sorted--;
+}
+
+
+// Orders by date, equal dates by creation order so iteration is deterministic
+int compare_battle_dates(const void *a, const void *b){
+  const struct battle_t *first = (*(struct battle_node_t *const *) a)->battle;
+  const struct battle_t *second = (*(struct battle_node_t *const *) b)->battle;
+
+  if (first->battle_date != second->battle_date) return first->battle_date < second->battle_date ? -1 : 1;
+  if (first->battle_id != second->battle_id) return first->battle_id < second->battle_id ? -1 : 1;
+  return 0;
+}
+
+
+// Sorts the unsorted tail and merges it into the sorted prefix
+void date_index_settle(struct galaxy_history_t *history){
+  size_t count = history->date_index_count;
+  size_t sorted = history->date_index_sorted;
+  if (sorted == count) return;
+
+  struct battle_node_t **index = history->date_index;
+  qsort(index + sorted, count - sorted, sizeof(struct battle_node_t *), compare_battle_dates);
+
+  // Merge through a copy of the prefix, without memory the whole array is sorted again
+  if (sorted){
+    struct battle_node_t **prefix = (struct battle_node_t **) malloc(sorted * sizeof(struct battle_node_t *));
+    if (!prefix){
+      qsort(index, count, sizeof(struct battle_node_t *), compare_battle_dates);
+      history->date_index_sorted = count;
+      return;
+    }
+    memcpy(prefix, index, sorted * sizeof(struct battle_node_t *));
+
+    size_t left = 0, right = sorted, out = 0;
+    while (left < sorted && right < count){
+      if (compare_battle_dates(&index[right], &prefix[left]) < 0) index[out++] = index[right++];
+      else index[out++] = prefix[left++];
+    }
+    while (left < sorted) index[out++] = prefix[left++];
+    free(prefix);
+  }
+  history->date_index_sorted = count;
+}
+
+
+// Position of the first battle dated `date` or later (index must be settled)
+size_t date_index_lower_bound(const struct galaxy_history_t *history, unsigned int date){
+  size_t low = 0, high = history->date_index_count;
+  while (low < high){
+    size_t mid = low + (high - low) / 2;
+    if (history->date_index[mid]->battle->battle_date < date) low = mid + 1;
+    else high = mid;
+  }
+  return low;
+}
+
+
+// Returns: The count of fleets with at least one of the `mask` bits set in battles dated
+//          from `date_from` to `date_to` (both included), -1 on error (e.g., NULL history).
+int count_fleets_with_status_bits_in_date_range(struct galaxy_history_t *history, unsigned int mask, unsigned int date_from, unsigned int date_to){
+  if (!history) return -1;
+  if (date_from > date_to) return 0;
+
+  date_index_settle(history);
+
+  size_t count = 0;
+  for (size_t i = date_index_lower_bound(history, date_from); i < history->date_index_count; ++i){
+    struct battle_t *battle = history->date_index[i]->battle;
+    if (battle->battle_date > date_to) break;
+    STATS_ADD(history, nodes_visited, 1);
+
+    // The battle's flags are one contiguous segment of the store
+    count += fleet_flags_count_any(history->store.status_flags + battle->store_offset, battle->num_fleets, (unsigned char) mask);
+  }
+  return (int) count;
+}
+
+
+// Returns: The number of battles visited, -1 on error (e.g., NULL history or visitor).
+int for_each_battle_in_date_range(struct galaxy_history_t *history, unsigned int date_from, unsigned int date_to, battle_visitor_t visitor, void *ctx){
+  if (!history || !visitor) return -1;
+  if (date_from > date_to) return 0;
+
+  date_index_settle(history);
+
+  int visited = 0;
+  for (size_t i = date_index_lower_bound(history, date_from); i < history->date_index_count; ++i){
+    struct battle_t *battle = history->date_index[i]->battle;
+    if (battle->battle_date > date_to) break;
+    STATS_ADD(history, nodes_visited, 1);
+
+    visited++;
+    if (visitor(battle, ctx) != 0) break;
+  }
+  return visited;
+}
@@ -1,53 +1,121 @@
 #include "galactic_func.h"
+#include "galactic_internal.h"
+#include "history_arena.h"
+#include "fleet_store.h"
+#include "fleet_simd.h"
+#include "string_pool.h"
+#include <assert.h>
+#include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Global strings for setting fleet status and printing
-char *first_bit = "Ready for Jump";
-char *second_bit = "Shield Active";
-char *third_bit = "Critical Damage";
-char *fourth_bit = "Withdrawal";
-// Function to set a fleet status
-unsigned char set_fleet_status(char *line){
-  if (!line) return -1;
-
-  unsigned char status = 0;
-  if (strstr(line, first_bit)){
-    //set first bit to one
-    status = status | (1 << 0);
+// Status field of a FLEET line -> its bit, 0 if the field names no status.
+// Fields are told apart by length first, so a field is compared at most twice.
+unsigned char status_field_bit(const char *field, size_t len){
+  switch (len){
+    case 10:
+      return memcmp(field, "Withdrawal", 10) == 0 ? 1u << 3 : 0;
+    case 13:
+      return memcmp(field, "Shield Active", 13) == 0 ? 1u << 1 : 0;
+    case 14:
+      if (memcmp(field, "Ready for Jump", 14) == 0) return 1u << 0;
+      // Spelling used by galactic_data.txt
+      return memcmp(field, "Shields Active", 14) == 0 ? 1u << 1 : 0;
+    case 15:
+      return memcmp(field, "Critical Damage", 15) == 0 ? 1u << 2 : 0;
+    default:
+      return 0;
   }
-  if (strstr(line, second_bit)){
-    //set second bit to one
-    status = status | (1 << 1);
-  }
-  if (strstr(line, third_bit)){
-    //set third bit to one
-    status = status | (1 << 2);
+}
+
+
+// Function to set a fleet status from a line that is not NUL-terminated.
+// Only the '|'-separated fields after name, 0 and ship count are statuses, each one trimmed
+// of surrounding blanks; empty fields are skipped and unknown ones counted in `unknown` (optional).
+unsigned char set_fleet_status_n(const char *line, size_t len, size_t *unknown){
+  if (!line) return 0;
+
+  const char *p = line;
+  const char *end = line + len;
+  for (int field = 0; field < 3; ++field){
+    p = (const char *) memchr(p, '|', (size_t) (end - p));
+    if (!p) return 0;
+    p++;
   }
-  if (strstr(line, fourth_bit)){
-    //set fourth bit to one
-    status = status | (1 << 3);
+
+  unsigned char status = 0;
+  for (;;){
+    const char *bar = (const char *) memchr(p, '|', (size_t) (end - p));
+    const char *from = p;
+    const char *to = bar ? bar : end;
+    while (from < to && isspace((unsigned char) *from)) from++;
+    while (to > from && isspace((unsigned char) to[-1])) to--;
+
+    if (from < to){
+      unsigned char bit = status_field_bit(from, (size_t) (to - from));
+      status |= bit;
+      if (!bit && unknown) (*unknown)++;
+    }
+    if (!bar) break;
+    p = bar + 1;
   }
 
   return status;
 }
 
+
+// Helper functions for memory allocation.........
+// With an arena every allocation is bumped from it and nothing is freed one by one.
+
+
+void *history_alloc(struct galaxy_history_t *history, size_t size){
+  STATS_ADD(history, bytes_allocated, size);
+  if (history->arena) return arena_alloc(history->arena, size);
+  return malloc(size);
+}
+
+
+void history_free(struct galaxy_history_t *history, void *ptr){
+  if (history->arena) return;
+  free(ptr);
+}
+
+
+// Resizes a block whose first `used_bytes` are live. Arena blocks cannot grow in place,
+// so a bigger one is bumped and the live part copied, shrinking keeps the old block.
+// With a retire hook readers may still hold the old block, so it is copied the same way
+// and handed to the hook instead of being freed by realloc.
+void *history_realloc(struct galaxy_history_t *history, void *ptr, size_t used_bytes, size_t new_bytes){
+  STATS_ADD(history, reallocs, 1);
+  STATS_ADD(history, bytes_allocated, new_bytes);
+  if (!history->arena && !history->retire) return realloc(ptr, new_bytes);
+  if (new_bytes <= used_bytes) return ptr;
+
+  void *resized = history->arena ? arena_alloc(history->arena, new_bytes) : malloc(new_bytes);
+  if (!resized) return NULL;
+  if (ptr) memcpy(resized, ptr, used_bytes);
+  if (ptr && !history->arena) history->retire(history->retire_ctx, ptr);
+  return resized;
+}
+
+
 // Helper functions for double linked list structure.........
 
 
 // creates new battle node and filles the data
-struct battle_node_t* create_new_battle(char *battle_name, unsigned int battle_date){
-  if (!battle_name) return NULL;
+struct battle_node_t* create_new_battle(struct galaxy_history_t *history, unsigned int name_id, unsigned int battle_date){
+  if (name_id >= history->names->count) return NULL;
 
   // Allocating memory for node
-  struct battle_node_t *node = (struct battle_node_t *) malloc(sizeof(struct battle_node_t));
+  struct battle_node_t *node = (struct battle_node_t *) history_alloc(history, sizeof(struct battle_node_t));
   if (!node) return NULL;
 
   // Allocating memory for battle
-  node->battle = (struct battle_t *) malloc(sizeof(struct battle_t));
+  node->battle = (struct battle_t *) history_alloc(history, sizeof(struct battle_t));
   if (!node->battle){
-    free(node);
+    history_free(history, node);
     return NULL;
   }
   node->next = NULL;
@@ -55,21 +123,20 @@ struct battle_node_t* create_new_battle(char *battle_name, unsigned int battle_d
 
   // Writing data to a battle struct
   struct battle_t *curr_battle = node->battle;
+  curr_battle->battle_name = (char *) history->names->entries[name_id].str;
+  curr_battle->name_id = name_id;
   curr_battle->battle_date = battle_date;
   curr_battle->num_fleets = 0;
-  curr_battle->battle_name = strdup(battle_name);
-  if (!curr_battle->battle_name){
-    free(node->battle);
-    free(node);
-    return NULL;
-  }
+  curr_battle->fleet_capacity = 4;
+  curr_battle->battle_id = 0;
+  curr_battle->store_offset = 0;
+  curr_battle->store_capacity = 0;
 
   // Allocating memory for fleet statuses struct
-  curr_battle->fleet_statuses = (struct fleet_status_t **) calloc(4, sizeof(struct fleet_status_t *)); // Capacity for 0 fleets + NULL, or 1 fleet.
+  curr_battle->fleet_statuses = (struct fleet_status_t **) history_alloc(history, 4 * sizeof(struct fleet_status_t *)); // Capacity for 0 fleets + NULL, or 1 fleet.
   if (!curr_battle->fleet_statuses){
-      free(curr_battle->battle_name);
-      free(node->battle);
-      free(node);
+      history_free(history, node->battle);
+      history_free(history, node);
       return NULL;
   }
   curr_battle->fleet_statuses[0] = NULL;
@@ -78,17 +145,29 @@ struct battle_node_t* create_new_battle(char *battle_name, unsigned int battle_d
 }
 
 
+// Frees a battle node that was never linked into the history
+void free_battle_node(struct galaxy_history_t *history, struct battle_node_t *node){
+  history_free(history, node->battle->fleet_statuses);
+  history_free(history, node->battle);
+  history_free(history, node);
+}
+
+
 // Fill fleet statuses in specific battle
-struct fleet_status_t *create_fleet_statuse(char *fleet_name, unsigned short total_ships, unsigned int status_flag){
+struct fleet_status_t *create_fleet_statuse(struct galaxy_history_t *history, const char *fleet_name, size_t name_len, unsigned int total_ships, unsigned int status_flag){
   if (!fleet_name) return NULL;
 
-  struct fleet_status_t *fleet = (struct fleet_status_t *) malloc(sizeof(struct fleet_status_t));
+  struct fleet_status_t *fleet = (struct fleet_status_t *) history_alloc(history, sizeof(struct fleet_status_t));
   if(!fleet){
     return NULL;
   }
 
-  fleet->fleet_name = strdup(fleet_name);
-  if (!fleet->fleet_name) return NULL;
+  unsigned int name_id = string_pool_intern(history->names, fleet_name, name_len);
+  if (name_id == STRING_POOL_NO_ID){
+    history_free(history, fleet);
+    return NULL;
+  }
+  fleet->fleet_name = (char *) history->names->entries[name_id].str;
 
   fleet->status_flags = status_flag;
   fleet->total_ships = total_ships;
@@ -96,9 +175,104 @@ struct fleet_status_t *create_fleet_statuse(char *fleet_name, unsigned short tot
 }
 
 
+// Helper functions for battle hash index.........
+
+
+// Hashes (battle_name, battle_date) key, the pooled FNV-1a hash of the name mixed with the date
+size_t battle_key_hash(size_t name_hash, unsigned int battle_date){
+  size_t hash = name_hash ^ battle_date;
+  hash *= (size_t) 1099511628211ULL;
+  return hash ^ (hash >> 29);
+}
+
+
+// Key hash of an indexed battle, the name is not read again
+size_t battle_node_hash(const struct galaxy_history_t *history, const struct battle_node_t *node){
+  return battle_key_hash(history->names->entries[node->battle->name_id].hash, node->battle->battle_date);
+}
+
+
+// Puts node into the first free slot of its probe sequence (index must have free slots)
+void battle_index_place(const struct galaxy_history_t *history, struct battle_node_t **index, size_t capacity, struct battle_node_t *node){
+  size_t slot = battle_node_hash(history, node) & (capacity - 1);
+  while (index[slot]) slot = (slot + 1) & (capacity - 1);
+  index[slot] = node;
+}
+
+
+// Inserts node into the index, growing it so the load factor stays under 1/2
+// Returns 0 on success, 4 on memory allocation error
+int battle_index_insert(struct galaxy_history_t *history, struct battle_node_t *node){
+  if (!history || !node || !node->battle) return 1;
+
+  if ((history->total_battles + 1) * 2 > history->index_capacity){
+    size_t capacity = history->index_capacity ? history->index_capacity * 2 : 16;
+    struct battle_node_t **index = (struct battle_node_t **) calloc(capacity, sizeof(struct battle_node_t *));
+    if (!index) return 4;
+    STATS_ADD(history, reallocs, 1);
+    STATS_ADD(history, bytes_allocated, capacity * sizeof(struct battle_node_t *));
+
+    // Rehash every indexed node into the bigger table
+    for (size_t i = 0; i < history->index_capacity; ++i){
+      if (history->battle_index[i]) battle_index_place(history, index, capacity, history->battle_index[i]);
+    }
+    free(history->battle_index);
+    history->battle_index = index;
+    history->index_capacity = capacity;
+  }
+
+  battle_index_place(history, history->battle_index, history->index_capacity, node);
+  return 0;
+}
+
+
+// Removes node from the index, shifting back the following entries of the probe run
+void battle_index_remove(struct galaxy_history_t *history, struct battle_node_t *node){
+  if (!history || !node || !history->index_capacity) return;
+
+  size_t mask = history->index_capacity - 1;
+  size_t slot = battle_node_hash(history, node) & mask;
+  while (history->battle_index[slot] && history->battle_index[slot] != node) slot = (slot + 1) & mask;
+  if (!history->battle_index[slot]) return;
+
+  // Backward shift deletion keeps probe runs contiguous without tombstones
+  size_t hole = slot;
+  size_t next = (slot + 1) & mask;
+  while (history->battle_index[next]){
+    size_t home = battle_node_hash(history, history->battle_index[next]) & mask;
+    // Entry may fill the hole only if its home slot is not inside (hole, next]
+    if (((next - home) & mask) >= ((next - hole) & mask)){
+      history->battle_index[hole] = history->battle_index[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  history->battle_index[hole] = NULL;
+}
+
+
+// Changes battle date and moves the node to its new index slot
+// Returns 0 on success, 4 on memory allocation error
+int set_battle_date(struct galaxy_history_t *history, struct battle_node_t *node, unsigned int battle_date){
+  battle_index_remove(history, node);
+  node->battle->battle_date = battle_date;
+  // Rare path (DATE after the fleets), the date index is simply sorted again
+  history->date_index_sorted = 0;
+  return battle_index_insert(history, node);
+}
+
+
 // Push front node
-void pushfront_node(struct galaxy_history_t *history , struct battle_node_t *current_battle){
-  if (!history || !current_battle) return;
+// Returns 0 on success, 4 on memory allocation error (node is not linked then)
+int pushfront_node(struct galaxy_history_t *history , struct battle_node_t *current_battle){
+  if (!history || !current_battle) return 1;
+
+  if (battle_index_insert(history, current_battle) != 0) return 4;
+  if (date_index_append(history, current_battle) != 0){
+    battle_index_remove(history, current_battle);
+    return 4;
+  }
+  current_battle->battle->battle_id = (unsigned int) history->battles_created++;
 
   current_battle->next = history->head;
 
@@ -107,8 +281,163 @@ void pushfront_node(struct galaxy_history_t *history , struct battle_node_t *cur
   else
     history->tail = current_battle;
 
-  history->head = current_battle;
-  return;
+  // Release store, so a reader walking from head sees the node filled in
+  __atomic_store_n(&history->head, current_battle, __ATOMIC_RELEASE);
+  return 0;
+}
+
+
+// Helper functions for fleet arrays.........
+
+
+// Makes room for `needed` fleets plus the trailing NULL, doubling the capacity so
+// appending k fleets one by one copies O(k) pointers in total
+// Returns 0 on success, 4 on memory allocation error
+int battle_reserve_fleets(struct galaxy_history_t *history, struct battle_t *battle, size_t needed){
+  if (needed + 1 <= battle->fleet_capacity) return 0;
+
+  size_t capacity = battle->fleet_capacity > 4 ? battle->fleet_capacity : 4;
+  while (capacity < needed + 1) capacity *= 2;
+
+  size_t used = (battle->num_fleets + 1) * sizeof(struct fleet_status_t *);
+  struct fleet_status_t **resized = (struct fleet_status_t **) history_realloc(history, battle->fleet_statuses, used, capacity * sizeof(struct fleet_status_t *));
+  if (!resized) return 4;
+
+  // Concurrent readers may load the array before the count that uses the new slots
+  __atomic_store_n(&battle->fleet_statuses, resized, __ATOMIC_RELEASE);
+  battle->fleet_capacity = capacity;
+  return 0;
+}
+
+
+// Trims the fleet array to the fleets plus the trailing NULL
+// Returns 0 on success, 4 on memory allocation error
+int battle_shrink_to_fit(struct galaxy_history_t *history, struct battle_t *battle){
+  // Arena blocks are never reused and retired blocks are freed late, shrinking gains nothing
+  if (history->arena || history->retire || battle->fleet_capacity == battle->num_fleets + 1) return 0;
+
+  struct fleet_status_t **resized = (struct fleet_status_t **) realloc(battle->fleet_statuses, (battle->num_fleets + 1) * sizeof(struct fleet_status_t *));
+  if (!resized) return 4;
+  STATS_ADD(history, reallocs, 1);
+
+  battle->fleet_statuses = resized;
+  battle->fleet_capacity = battle->num_fleets + 1;
+  return 0;
+}
+
+
+// Helper functions for file loading.........
+
+
+// Makes the (battle_name, battle_date) battle the one receiving fleets.
+// Merges into the indexed battle with the same key or creates a new node.
+// Returns 0 on success, 4 on memory allocation error
+int loader_switch_battle(struct history_loader_t *loader, const char *battle_name, size_t name_len, unsigned int battle_date){
+  struct string_pool_t *names = loader->history->names;
+  size_t hash = string_pool_hash(battle_name, name_len);
+
+  unsigned int name_id = string_pool_find(names, battle_name, name_len, hash);
+  struct battle_node_t *existing = name_id == STRING_POOL_NO_ID ? NULL : find_battle_node_id(loader->history, name_id, battle_date);
+  if (existing){
+    loader->current = existing;
+    return 0;
+  }
+
+  // Creating new battle node
+  name_id = string_pool_intern_hashed(names, battle_name, name_len, hash);
+  if (name_id == STRING_POOL_NO_ID) return 4;
+  struct battle_node_t *new_battle = create_new_battle(loader->history, name_id, battle_date);
+  if (!new_battle) return 4;
+
+  if (pushfront_node(loader->history, new_battle) != 0){
+    free_battle_node(loader->history, new_battle);
+    return 4;
+  }
+  loader->history->total_battles++;
+  loader->current = new_battle;
+  return 0;
+}
+
+
+// Appends fleet to the battle being filled
+// Returns 0 on success, 4 on memory allocation error (fleet is not taken then)
+int loader_append_fleet(struct history_loader_t *loader, struct fleet_status_t *fleet){
+  struct battle_t *battle = loader->current->battle;
+
+  if (fleet_store_reserve(&loader->history->store, battle, battle->num_fleets + 1) != 0) return 4;
+  if (battle_reserve_fleets(loader->history, battle, battle->num_fleets + 1) != 0) return 4;
+
+  fleet_store_set(&loader->history->store, battle, battle->num_fleets, fleet->status_flags, fleet->total_ships);
+  battle->fleet_statuses[battle->num_fleets++] = fleet;
+  battle->fleet_statuses[battle->num_fleets] = NULL;
+  return 0;
+}
+
+
+// Dates the battle whose fleets came before its DATE record. When (name, date) is already
+// loaded, the fleets are appended to that battle, as if the DATE had come first, and the
+// dated-0 node is dropped. Returns 0 on success, 4 on memory allocation error
+int loader_set_date(struct history_loader_t *loader, unsigned int battle_date){
+  struct galaxy_history_t *history = loader->history;
+  struct battle_node_t *node = loader->current;
+  struct battle_t *battle = node->battle;
+
+  struct battle_node_t *existing = find_battle_node_id(history, battle->name_id, battle_date);
+  if (!existing || existing == node) return set_battle_date(history, node, battle_date);
+
+  struct battle_t *target = existing->battle;
+  size_t total = target->num_fleets + battle->num_fleets;
+  if (fleet_store_reserve(&history->store, target, total) != 0) return 4;
+  if (battle_reserve_fleets(history, target, total) != 0) return 4;
+
+  fleet_store_release(&history->store, battle);
+  for (size_t i = 0; i < battle->num_fleets; ++i){
+    struct fleet_status_t *fleet = battle->fleet_statuses[i];
+    fleet_store_set(&history->store, target, target->num_fleets, fleet->status_flags, fleet->total_ships);
+    target->fleet_statuses[target->num_fleets++] = fleet;
+  }
+  target->fleet_statuses[target->num_fleets] = NULL;
+
+  // The name was already known, so the pool counters forget the second intern
+  history->names->interned--;
+  history->names->bytes_requested -= history->names->entries[battle->name_id].len + 1;
+
+  // Unlinking the dated-0 node from the indexes and the list
+  battle_index_remove(history, node);
+  date_index_remove(history, node);
+  if (node->prev) node->prev->next = node->next;
+  else history->head = node->next;
+  if (node->next) node->next->prev = node->prev;
+  else history->tail = node->prev;
+  history->total_battles--;
+
+  free_battle_node(history, node);
+  loader->current = existing;
+  return 0;
+}
+
+
+// Helper functions for fleet status changes.........
+
+
+// Applies the bit operation to every fleet of the battle, without any output
+// Returns the number of fleets modified, -1 on unknown operation type
+int apply_fleet_status_operation(struct galaxy_history_t *history, struct battle_t *battle, int operation_type, unsigned int mask){
+  if (operation_type < 0 || operation_type > 2) return -1;
+  if (!battle->num_fleets) return 0;
+
+  // The battle's flags are contiguous in the store, so the operation runs vectorized there
+  unsigned char *store_flags = history->store.status_flags + battle->store_offset;
+  fleet_flags_apply(store_flags, battle->num_fleets, operation_type, (unsigned char) mask);
+
+  // Copy the results back to the fleet structs, moving each fleet in the counters.
+  // Concurrent readers load the flags atomically, a relaxed store is a plain byte store.
+  for (size_t i = 0; i < battle->num_fleets; ++i){
+    fleet_store_recount(&history->store, battle->fleet_statuses[i]->status_flags, store_flags[i]);
+    __atomic_store_n(&battle->fleet_statuses[i]->status_flags, store_flags[i], __ATOMIC_RELAXED);
+  }
+
+  return (int) battle->num_fleets;
 }
 
 
@@ -128,11 +457,60 @@ int initialize_history(struct galaxy_history_t **history_ptr){
   *history_ptr = (struct galaxy_history_t *) malloc(sizeof(struct galaxy_history_t));
   if (!*history_ptr) return 4; // Memory allocation error
 
+  (*history_ptr)->names = (struct string_pool_t *) malloc(sizeof(struct string_pool_t));
+  if (!(*history_ptr)->names){
+    free(*history_ptr);
+    *history_ptr = NULL;
+    return 4;
+  }
+  string_pool_init((*history_ptr)->names);
+
   // Init history
   (*history_ptr)->head = NULL;
   (*history_ptr)->tail = NULL;
   (*history_ptr)->total_battles = 0;
+  (*history_ptr)->battles_created = 0;
+  (*history_ptr)->battle_index = NULL;
+  (*history_ptr)->index_capacity = 0;
+  (*history_ptr)->arena = NULL;
+  fleet_store_init(&(*history_ptr)->store);
+  (*history_ptr)->date_index = NULL;
+  (*history_ptr)->date_index_count = 0;
+  (*history_ptr)->date_index_sorted = 0;
+  (*history_ptr)->date_index_capacity = 0;
+  (*history_ptr)->snapshot_map = NULL;
+  (*history_ptr)->snapshot_size = 0;
+  (*history_ptr)->retire = NULL;
+  (*history_ptr)->retire_ctx = NULL;
+  (*history_ptr)->unknown_statuses = 0;
+  (*history_ptr)->stats = NULL;
+
+#ifdef GALACTIC_STATS
+  (*history_ptr)->stats = (struct history_stats_t *) calloc(1, sizeof(struct history_stats_t));
+  if (!(*history_ptr)->stats){
+    free((*history_ptr)->names);
+    free(*history_ptr);
+    *history_ptr = NULL;
+    return 4;
+  }
+  (*history_ptr)->store.stats = (*history_ptr)->stats;
+#endif
+  return 0;
+}
 
+
+// Returns 0 on success, 1 on error (e.g., NULL history_ptr), 4 on memory allocation error.
+int initialize_history_with_arena(struct galaxy_history_t **history_ptr, size_t block_size){
+  int res = initialize_history(history_ptr);
+  if (res != 0) return res;
+
+  struct history_arena_t *arena = (struct history_arena_t *) malloc(sizeof(struct history_arena_t));
+  if (!arena){
+    destroy_galactic_history(history_ptr);
+    return 4;
+  }
+  arena_init(arena, block_size);
+  (*history_ptr)->arena = arena;
   return 0;
 }
 
@@ -150,198 +528,125 @@ int load_galactic_history(const char *fname, struct galaxy_history_t **history_p
   unsigned int battle_date, total_ships;
 
   // Entering main loop
-  int resize = 3;
-  struct battle_node_t *current_battle_node = NULL; // Track the battle being currently populated
-  while (fgets(line, sizeof(line), fptr) != NULL && *line != '\n'){
+  struct history_loader_t loader = {*history_ptr, NULL};
+  int pending = 0; // BATTLE line read but its node is not resolved yet (waits for the DATE line)
+  int res = 0;
+  // Time waiting for fgets is read, the rest of a line is parse until it reaches the history
+  STATS_CLOCK(clock, HISTORY_PHASE_READ);
+  while ((STATS_PHASE(loader.history, clock, HISTORY_PHASE_READ), fgets(line, sizeof(line), fptr)) != NULL && *line != '\n'){
+    STATS_PHASE(loader.history, clock, HISTORY_PHASE_PARSE);
 
     if (strstr(line, "BATTLE:") == line){
-      if (current_battle_node && current_battle_node->battle && current_battle_node->battle->fleet_statuses){
-        size_t fleets_count = current_battle_node->battle->num_fleets;
-        // Trim unused allocated memory for the *previous* battle
-        struct fleet_status_t **resized = (struct fleet_status_t **) realloc(current_battle_node->battle->fleet_statuses, (fleets_count + 1) * sizeof(struct fleet_status_t *));
-        if (!resized) {
-            fclose(fptr);
-            destroy_galactic_history(history_ptr);
-            return 4;
-        }
-        current_battle_node->battle->fleet_statuses = resized;
-        current_battle_node->battle->fleet_statuses[fleets_count] = NULL;
-      }
-
-      if (sscanf(line, "BATTLE:%57[^\n]", battle_name) == 1){
-
-        // check for battle name if exists
-        int check = 0;
-        if (current_battle_node){
-          struct battle_node_t *current = (*history_ptr)->head;
-          while(current) {
-            if (!current->battle) {current = current->next; continue;}
-
-            if (strcmp(current->battle->battle_name, battle_name) == 0) {
-              check = 1;
-              break;
-            }
-            current = current->next;
-          }
-          if (check){
-            current_battle_node = current;
-            continue;
-          }
-        }
+      // Battle without DATE and fleets is still kept, dated 0
+      if (pending && (res = loader_switch_battle(&loader, battle_name, strlen(battle_name), 0)) != 0) break;
 
-        // Creating new battle node
-        struct battle_node_t *new_battle = create_new_battle(battle_name, 0);
-        if(!new_battle){
-            fclose(fptr);
-            destroy_galactic_history(history_ptr);
-            return 4;
-        }
-        pushfront_node(*history_ptr, new_battle);
-        (*history_ptr)->total_battles++;
-        current_battle_node = new_battle;
-        continue;
-      } else {
-        fclose(fptr);
-        destroy_galactic_history(history_ptr);
-        return 3; // Malformed BATTLE line
+      if (sscanf(line, "BATTLE:%57[^\n]", battle_name) != 1){
+        res = 3; // Malformed BATTLE line
+        break;
       }
+      pending = 1;
+      continue;
     }
 
 
     if (sscanf(line, "DATE:%u", &battle_date) == 1){
-      if (!current_battle_node || !current_battle_node->battle) {
-        fclose(fptr);
-        destroy_galactic_history(history_ptr);
-        return 3; // Corrupted file: DATE without BATTLE
-      }
-      if (current_battle_node->battle->battle_date == 0){
-        current_battle_node->battle->battle_date = battle_date;
-        continue;
-      }
-      // Check if battle with existing date is equal date if yes ok if not creating new battle node with same name but different date
-      struct battle_node_t *current = (*history_ptr)->head;
-      int check = 0;
-      while(current) {
-        if (!current->battle) {current = current->next; continue;}
-
-        if (strcmp(current->battle->battle_name, battle_name) == 0 && current->battle->battle_date == battle_date){
-          check = 1;
-          break;
-        }
-        else if (strcmp(current->battle->battle_name, battle_name) == 0 && current->battle->battle_date != battle_date){
-          check = 2;
-          break;
-        }
-        current = current->next;
+      if (!pending && !loader.current){
+        res = 3; // Corrupted file: DATE without BATTLE
+        break;
       }
-      if (check == 1){
-        current_battle_node = current;
-        continue;
-      }
-      if (check == 2){
-        // Creating new battle node
-        struct battle_node_t *new_battle = create_new_battle(battle_name, 0);
-        if(!new_battle){
-            fclose(fptr);
-            destroy_galactic_history(history_ptr);
-            return 4;
-        }
-        pushfront_node(*history_ptr, new_battle);
-        (*history_ptr)->total_battles++;
-        current_battle_node = new_battle;
-        current_battle_node->battle->battle_date = battle_date;
+      STATS_PHASE(loader.history, clock, HISTORY_PHASE_BUILD);
+      // Fleets came before the DATE line, so the battle was created dated 0
+      if (!pending && loader.current->battle->battle_date == 0){
+        if ((res = loader_set_date(&loader, battle_date)) != 0) break;
         continue;
       }
+      // Same name with same date merges, same name with different date creates new node
+      if ((res = loader_switch_battle(&loader, battle_name, strlen(battle_name), battle_date)) != 0) break;
+      pending = 0;
+      continue;
     }
 
     if (strstr(line, "FLEET:") == line && sscanf(line, "FLEET:%57[^|]|%*d|%u|", fleet_name, &total_ships) == 2){ // Use %*d to skip the 0
-      if (!current_battle_node || !current_battle_node->battle) {
-        fclose(fptr);
-        destroy_galactic_history(history_ptr);
-        return 3; // Corrupted file: FLEET without BATTLE
-      }
+      unsigned char status_flag = set_fleet_status_n(line, strlen(line), &loader.history->unknown_statuses);
+      STATS_PHASE(loader.history, clock, HISTORY_PHASE_BUILD);
 
-      struct battle_t *current_battle_data = current_battle_node->battle;
-
-      // Check if we need to resize the fleet_statuses array
-      if ((int)current_battle_data->num_fleets >= resize) {
-          resize += 4;
-
-          struct fleet_status_t **temp = (struct fleet_status_t **) realloc(current_battle_data->fleet_statuses, resize * sizeof(struct fleet_status_t *));
-          if (!temp){
-            fclose(fptr);
-            destroy_galactic_history(history_ptr);
-            return 4;
-          }
-          current_battle_data->fleet_statuses = temp;
+      if (pending){
+        if ((res = loader_switch_battle(&loader, battle_name, strlen(battle_name), 0)) != 0) break;
+        pending = 0;
+      }
+      if (!loader.current){
+        res = 3; // Corrupted file: FLEET without BATTLE
+        break;
       }
 
-      unsigned char status_flag = set_fleet_status(line);
-
-      current_battle_data->fleet_statuses[current_battle_data->num_fleets] = create_fleet_statuse(fleet_name, total_ships, status_flag);
-      if (!current_battle_data->fleet_statuses[current_battle_data->num_fleets]) {
-        fclose(fptr);
-        destroy_galactic_history(history_ptr);
-        return 4;
+      struct fleet_status_t *fleet = create_fleet_statuse(loader.history, fleet_name, strlen(fleet_name), total_ships, status_flag);
+      if (!fleet){
+        res = 4;
+        break;
+      }
+      if ((res = loader_append_fleet(&loader, fleet)) != 0){
+        history_free(loader.history, fleet);
+        break;
       }
-      current_battle_data->num_fleets++;
       continue;
     }
     else {
       if (strlen(line) > 1) {
-        fclose(fptr);
-        destroy_galactic_history(history_ptr);
-        return 3; // Corrupted file format
+        res = 3; // Corrupted file format
+        break;
       }
     }
   }
 
-  // After the loop, the last battle's fleet_statuses array needs to be finalized
-  if((*history_ptr)->head && (*history_ptr)->head->battle && (*history_ptr)->head->battle->fleet_statuses){
-    size_t fleets_count = (*history_ptr)->head->battle->num_fleets;
-    struct fleet_status_t **resized = (struct fleet_status_t **) realloc((*history_ptr)->head->battle->fleet_statuses, (fleets_count + 1) * sizeof(struct fleet_status_t *));
-    if (!resized) {
-      fclose(fptr);
-      destroy_galactic_history(history_ptr);
-      return 4;
-    }
-    (*history_ptr)->head->battle->fleet_statuses = resized;
-    (*history_ptr)->head->battle->fleet_statuses[fleets_count] = NULL;
+  if (!res && pending){
+    STATS_PHASE(loader.history, clock, HISTORY_PHASE_BUILD);
+    res = loader_switch_battle(&loader, battle_name, strlen(battle_name), 0);
   }
+  STATS_PHASE(loader.history, clock, HISTORY_PHASES);
 
   fclose(fptr);
-  return 0;
+  if (res) destroy_galactic_history(history_ptr);
+  return res;
 }
 
 
 void destroy_galactic_history(struct galaxy_history_t **history_ptr){
   if (!history_ptr || !*history_ptr) return;
 
+  if ((*history_ptr)->snapshot_map) release_snapshot_mapping(*history_ptr);
+
+  // Everything lives in the arena, so teardown is a single release
+  if ((*history_ptr)->arena){
+    arena_release((*history_ptr)->arena);
+    free((*history_ptr)->arena);
+    string_pool_free((*history_ptr)->names);
+    free((*history_ptr)->names);
+    fleet_store_free(&(*history_ptr)->store);
+    free((*history_ptr)->battle_index);
+    free((*history_ptr)->date_index);
+    free((*history_ptr)->stats);
+    free(*history_ptr);
+    *history_ptr = NULL;
+    return;
+  }
+
   struct battle_node_t *current = (*history_ptr)->head;
 
   while(current){
     struct battle_node_t *next = current->next;
 
     if (current->battle){
+      // Names belong to the name pool, freed below
       if (current->battle->fleet_statuses){
         struct fleet_status_t **fleet_ptr_iter = current->battle->fleet_statuses;
         while (*fleet_ptr_iter) {
-            struct fleet_status_t *fleet_to_free = *fleet_ptr_iter;
-            if (fleet_to_free->fleet_name) {
-                free(fleet_to_free->fleet_name);
-            }
-            free(fleet_to_free);
+            free(*fleet_ptr_iter);
             fleet_ptr_iter++;
         }
         free(current->battle->fleet_statuses);
         current->battle->fleet_statuses = NULL;
       }
 
-      if (current->battle->battle_name) {
-          free(current->battle->battle_name);
-          current->battle->battle_name = NULL;
-      }
-
       free(current->battle);
       current->battle = NULL;
     }
@@ -349,6 +654,12 @@ void destroy_galactic_history(struct galaxy_history_t **history_ptr){
     free(current);
     current = next;
   }
+  free((*history_ptr)->battle_index);
+  free((*history_ptr)->date_index);
+  string_pool_free((*history_ptr)->names);
+  free((*history_ptr)->names);
+  fleet_store_free(&(*history_ptr)->store);
+  free((*history_ptr)->stats);
   free(*history_ptr);
   *history_ptr = NULL;
 }
@@ -357,36 +668,72 @@ void destroy_galactic_history(struct galaxy_history_t **history_ptr){
 void display_galactic_history(const struct galaxy_history_t *history){
     if (!history) return;
 
-    struct battle_node_t *current = history->head;
+    // Same text as before, emitted through the buffered writer instead of printf per field
+    struct history_writer_t writer;
+    writer_open(&writer, stdout);
+    fflush(stdout);
+
+    // Links, fleet arrays, counts and flags are loaded atomically, so concurrent readers
+    // (galactic_concurrent.h) can display while a writer publishes changes
+    struct battle_node_t *current = __atomic_load_n(&history->head, __ATOMIC_ACQUIRE);
 
     while(current){
+        STATS_ADD(history, nodes_visited, 1);
         // Make sure current->battle is not NULL before accessing its members
         if (!current->battle) {
-            current = current->next;
+            current = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
             continue;
         }
 
-        printf("%s WAS ON %u YEARS AFTER FIRST GALACTIC ERA\nTOTAL AMOUNT OF FLEETS : %zu\n", current->battle->battle_name, current->battle->battle_date, current->battle->num_fleets);
+        size_t num_fleets = __atomic_load_n(&current->battle->num_fleets, __ATOMIC_ACQUIRE);
+        struct fleet_status_t **fleets = __atomic_load_n(&current->battle->fleet_statuses, __ATOMIC_ACQUIRE);
+
+        writer_puts(&writer, current->battle->battle_name);
+        writer_puts(&writer, " WAS ON ");
+        writer_put_number(&writer, current->battle->battle_date);
+        writer_puts(&writer, " YEARS AFTER FIRST GALACTIC ERA\nTOTAL AMOUNT OF FLEETS : ");
+        writer_put_number(&writer, num_fleets);
+        writer_putc(&writer, '\n');
 
-        for (unsigned int i = 0; i < current->battle->num_fleets; ++i){
-            struct fleet_status_t *temp = current->battle->fleet_statuses[i];
+        for (unsigned int i = 0; i < num_fleets; ++i){
+            struct fleet_status_t *temp = fleets[i];
             // Check if temp is NULL before dereferencing
             if (!temp) {
-                printf("Error: Fleet status at index %u is NULL.\n", i);
+                writer_puts(&writer, "Error: Fleet status at index ");
+                writer_put_number(&writer, i);
+                writer_puts(&writer, " is NULL.\n");
                 continue; // Skip to the next fleet
             }
 
-            printf("%s AMOUNT OF SHIPS IN THIS FLEET %u\n", temp->fleet_name, temp->total_ships);
-            printf("status flags: ");
-            if (temp->status_flags & (1u << 0)) printf("Ready for Jump ");
-            if (temp->status_flags & (1u << 1)) printf("Shield Active ");
-            if (temp->status_flags & (1u << 2)) printf("Critical Damage ");
-            if (temp->status_flags & (1u << 3)) printf("Withdrawal ");
-            printf("\n");
+            unsigned char flags = __atomic_load_n(&temp->status_flags, __ATOMIC_RELAXED);
+            writer_puts(&writer, temp->fleet_name);
+            writer_puts(&writer, " AMOUNT OF SHIPS IN THIS FLEET ");
+            writer_put_number(&writer, temp->total_ships);
+            writer_puts(&writer, "\nstatus flags: ");
+            for (int bit = 0; bit < 4; ++bit){
+                if (!(flags & (1u << bit))) continue;
+                writer_puts(&writer, status_bit_names[bit]);
+                writer_putc(&writer, ' ');
+            }
+            writer_putc(&writer, '\n');
         }
-        printf("\n");
-        current = current->next;
+        writer_putc(&writer, '\n');
+        current = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
     }
+
+    writer_close(&writer);
+    fflush(stdout);
+}
+
+
+// Reference count over every fleet of the battle list, as before the counters existed
+size_t count_fleets_by_traversal(const struct galaxy_history_t *history, unsigned char mask){
+  size_t count = 0;
+  for (const struct battle_node_t *current = history->head; current; current = current->next){
+    struct fleet_status_t **fleets = current->battle->fleet_statuses;
+    for (size_t i = 0; i < current->battle->num_fleets; ++i) count += (fleets[i]->status_flags & mask) != 0;
+  }
+  return count;
 }
 
 
@@ -395,23 +742,28 @@ void display_galactic_history(const struct galaxy_history_t *history){
 // Returns: The count of fleets meeting the criteria, -1 on error (e.g., NULL history).
 int count_fleets_with_status_bits(const struct galaxy_history_t *history, unsigned int mask){
   if (!history) return -1;
-  int count = 0;
-
-  struct battle_node_t *current = history->head;
-
-  while(current) {
-    if (!current->battle) {current = current->next; continue;}
-    struct fleet_status_t **curr_fleet = current->battle->fleet_statuses;
-    while(*curr_fleet){
-      struct fleet_status_t *iner_fleet = *curr_fleet;
-      if (!iner_fleet) {curr_fleet++; continue;}
-      if (iner_fleet->status_flags & mask) count++;
-      curr_fleet++;
-    }
-    current = current->next;
-  }
 
-  return count;
+  // Counters are a cache, the history itself is not changed
+  struct fleet_store_t *store = (struct fleet_store_t *) &history->store;
+
+  // Flags are a single byte, higher mask bits can never match
+  size_t count = fleet_store_cached_count(store, (unsigned char) mask);
+
+#ifdef GALACTIC_DEBUG_COUNTERS
+  // Checked against the fleet structs, not the store the counters are kept next to
+  assert(count == count_fleets_by_traversal(history, (unsigned char) mask));
+#endif
+  return (int) count;
+}
+
+
+// Returns the sum of total_ships over fleets that have at least one of the specified
+// status bits set.
+// Returns: The sum of ships, -1 on error (e.g., NULL history).
+long long sum_ships_with_status_bits(const struct galaxy_history_t *history, unsigned int mask){
+  if (!history) return -1;
+
+  return (long long) fleet_store_sum_ships(&history->store, (unsigned char) mask);
 }
 
 
@@ -423,77 +775,192 @@ int count_fleets_with_status_bits(const struct galaxy_history_t *history, unsign
 int modify_fleet_statuses_in_battle(struct galaxy_history_t *history, const char *battle_name, unsigned int date, int operation_type, unsigned int mask){
   if (!history || !battle_name) return -1;
 
-  int count = 0;
-  int check = 0;
-
-  struct battle_node_t *current = history->head;
-
-  while(current) {
-    if (!current->battle) {current = current->next; continue;}
-
-    if (strcmp(current->battle->battle_name, battle_name) == 0 && current->battle->battle_date == date){
-      struct fleet_status_t **curr_fleet = current->battle->fleet_statuses;
-      while(*curr_fleet){
-        struct fleet_status_t *iner_fleet = *curr_fleet;
-        if (!iner_fleet) {curr_fleet++; continue;}
-        switch (operation_type){
-          case 0:
-            iner_fleet->status_flags |= mask;
-            break;
-          case 1:
-            iner_fleet->status_flags &= ~mask;
-            break;
-          case 2:
-            iner_fleet->status_flags ^= mask;
-            break;
-          default:
-            printf("Not existing operation type!\nModified fleets until error: %d", count);
-            return -1;
-        }
-        count++;
-        curr_fleet++;
-      }
-      check = 1;
-      break;
-    }
-    current = current->next;
-  }
-
-  if (!check){
+  struct battle_node_t *current = find_battle_node(history, battle_name, date);
+  if (!current){
     printf("Battle not found!\n");
     return -1;
   }
 
+  int count = apply_fleet_status_operation(history, current->battle, operation_type, mask);
+  if (count < 0) printf("Not existing operation type!\n");
   return count;
 }
 
 
+// Applies a list of status changes, each command is looked up through the battle index.
+// Returns: The number of commands applied, -1 on invalid input.
+int modify_fleet_statuses_batch(struct galaxy_history_t *history, const struct fleet_status_command_t *commands, size_t count, int *results){
+  if (!history || (!commands && count) || (!results && count)) return -1;
+
+  int applied = 0;
+  for (size_t i = 0; i < count; ++i){
+    const struct fleet_status_command_t *command = &commands[i];
+    struct battle_node_t *target = command->battle_name ? find_battle_node(history, command->battle_name, command->date) : NULL;
+
+    results[i] = target ? apply_fleet_status_operation(history, target->battle, command->operation_type, command->mask) : -1;
+    if (results[i] >= 0) applied++;
+  }
+  return applied;
+}
+
+
 // Returns: 0 on success, 1 on invalid input, 2 - battle not found, 4 - memory allocation failure
 int add_fleet_to_battle(struct galaxy_history_t *history, const char *battle_name,unsigned int date, struct fleet_status_t *new_fleet){
-  if (!history || !battle_name || !new_fleet) return 1;
+  return add_fleets_to_battle(history, battle_name, date, &new_fleet, 1);
+}
 
-  struct battle_node_t *current = history->head;
-  int check = 0;
 
-  while(current) {
-    if (!current->battle) {current = current->next; continue;}
+// Everything that can fail is reserved first, so the fleets are taken over all at once or not at all.
+// Returns: 0 on success, 1 on invalid input, 2 - battle not found, 4 - memory allocation failure
+// Orders fleet pointers by address
+int compare_fleet_pointers(const void *first, const void *second){
+  uintptr_t a = (uintptr_t) *(struct fleet_status_t *const *) first;
+  uintptr_t b = (uintptr_t) *(struct fleet_status_t *const *) second;
+  return (a > b) - (a < b);
+}
+
+
+int add_fleets_to_battle(struct galaxy_history_t *history, const char *battle_name, unsigned int date, struct fleet_status_t **fleets, size_t count){
+  if (!history || !battle_name || (!fleets && count)) return 1;
+  for (size_t i = 0; i < count; ++i){
+    if (!fleets[i]) return 1;
+  }
 
-    if (strcmp(current->battle->battle_name, battle_name) == 0 && current->battle->battle_date == date){
-      size_t size = current->battle->num_fleets + 2;
-      struct fleet_status_t **resized = (struct fleet_status_t **) realloc(current->battle->fleet_statuses,  size * sizeof(struct fleet_status_t *));
+  struct battle_node_t *current = find_battle_node(history, battle_name, date);
+  if (!current) return 2;
+  if (!count) return 0;
+
+  struct battle_t *battle = current->battle;
+  size_t index = battle->num_fleets;
+
+  // One block holds the name ids and a sorted copy of the fleet pointers
+  unsigned int local_ids[16];
+  struct fleet_status_t *local_sorted[16];
+  unsigned int *name_ids = local_ids;
+  struct fleet_status_t **sorted = local_sorted;
+  void *scratch = NULL;
+  if (count > 16){
+    scratch = malloc(count * (sizeof(struct fleet_status_t *) + sizeof(unsigned int)));
+    if (!scratch) return 4;
+    sorted = (struct fleet_status_t **) scratch;
+    name_ids = (unsigned int *) (sorted + count);
+  }
+
+  // A fleet listed twice would be owned twice and its pooled name freed by the second copy
+  memcpy(sorted, fleets, count * sizeof(struct fleet_status_t *));
+  qsort(sorted, count, sizeof(struct fleet_status_t *), compare_fleet_pointers);
+  for (size_t i = 1; i < count; ++i){
+    if (sorted[i] == sorted[i - 1]){
+      free(scratch);
+      return 1;
+    }
+  }
+
+  // Names are interned up front. A later failure restores the interning counters, names seen
+  // for the first time stay stored as unused pool entries.
+  size_t interned = history->names->interned;
+  size_t bytes_requested = history->names->bytes_requested;
+  int res = 0;
+  for (size_t i = 0; i < count && !res; ++i){
+    const char *name = fleets[i]->fleet_name;
+    name_ids[i] = name ? string_pool_intern(history->names, name, strlen(name)) : STRING_POOL_NO_ID;
+    if (name && name_ids[i] == STRING_POOL_NO_ID) res = 4;
+  }
 
-      if (!resized) return 4;
+  // Caller's fleets are heap memory, the arena takes them over to free them on release
+  if (!res && history->arena && arena_reserve_adopted(history->arena, count) != 0) res = 4;
+  if (!res && fleet_store_reserve(&history->store, battle, index + count) != 0) res = 4;
+  if (!res && battle_reserve_fleets(history, battle, index + count) != 0) res = 4;
+  if (res){
+    history->names->interned = interned;
+    history->names->bytes_requested = bytes_requested;
+    free(scratch);
+    return res;
+  }
 
-      current->battle->fleet_statuses = resized;
-      current->battle->fleet_statuses[current->battle->num_fleets] = new_fleet;
-      current->battle->num_fleets++;
-      current->battle->fleet_statuses[current->battle->num_fleets] = NULL;
-      check = 1;
-      break;
+  for (size_t i = 0; i < count; ++i){
+    struct fleet_status_t *fleet = fleets[i];
+    if (history->arena) arena_adopt(history->arena, fleet);
+    // The caller's copy of the name is replaced by the pooled one
+    if (fleet->fleet_name){
+      free(fleet->fleet_name);
+      fleet->fleet_name = (char *) history->names->entries[name_ids[i]].str;
     }
-    current = current->next;
+    fleet_store_set(&history->store, battle, index + i, fleet->status_flags, fleet->total_ships);
+    battle->fleet_statuses[index + i] = fleet;
   }
+  free(scratch);
+
+  // Concurrent readers load num_fleets and then fleet_statuses, so the slots are filled
+  // before the count that makes the new fleets visible
+  battle->fleet_statuses[index + count] = NULL;
+  __atomic_store_n(&battle->num_fleets, index + count, __ATOMIC_RELEASE);
+  return 0;
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL).
+int get_name_pool_stats(const struct galaxy_history_t *history, struct name_pool_stats_t *stats){
+  if (!history || !stats) return 1;
+
+  const struct string_pool_t *names = history->names;
+  stats->names_interned = names->interned;
+  stats->distinct_names = names->count;
+  stats->bytes_requested = names->bytes_requested;
+  stats->bytes_stored = names->bytes_stored;
+  stats->table_bytes = names->capacity * sizeof(struct pool_entry_t) + names->slot_capacity * sizeof(unsigned int);
+  return 0;
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL), 4 - memory allocation error.
+int shrink_fleet_statuses_to_fit(struct galaxy_history_t *history){
+  if (!history) return 1;
 
-  if (!check) return 2;
+  for (struct battle_node_t *current = history->head; current; current = current->next){
+    STATS_ADD(history, nodes_visited, 1);
+    if (battle_shrink_to_fit(history, current->battle) != 0) return 4;
+  }
   return 0;
 }
+
+
+// Looks up a battle by its (name, date) key through the history hash index.
+// Returns: The node holding the battle, or NULL if not found or on invalid input.
+struct battle_node_t *find_battle_node(const struct galaxy_history_t *history, const char *battle_name, unsigned int date){
+  if (!battle_name) return NULL;
+
+  return find_battle_node_n(history, battle_name, strlen(battle_name), date);
+}
+
+
+// Same lookup for a name that is not NUL-terminated. A name missing from the pool cannot
+// belong to any battle, otherwise the index is probed with its id.
+struct battle_node_t *find_battle_node_n(const struct galaxy_history_t *history, const char *battle_name, size_t name_len, unsigned int date){
+  if (!history || !battle_name || !history->index_capacity) return NULL;
+
+  unsigned int name_id = string_pool_find(history->names, battle_name, name_len, string_pool_hash(battle_name, name_len));
+  if (name_id == STRING_POOL_NO_ID) return NULL;
+  return find_battle_node_id(history, name_id, date);
+}
+
+
+// Lookup by pooled name id, keys compare as two integers
+struct battle_node_t *find_battle_node_id(const struct galaxy_history_t *history, unsigned int name_id, unsigned int date){
+  if (!history->index_capacity) return NULL;
+
+  size_t mask = history->index_capacity - 1;
+  size_t slot = battle_key_hash(history->names->entries[name_id].hash, date) & mask;
+
+  // Linear probing until the first empty slot
+  while (history->battle_index[slot]){
+    STATS_ADD(history, index_probes, 1);
+    STATS_ADD(history, name_compares, 1);
+    struct battle_t *battle = history->battle_index[slot]->battle;
+    if (battle->name_id == name_id && battle->battle_date == date) return history->battle_index[slot];
+    slot = (slot + 1) & mask;
+  }
+  // The empty slot ending the run
+  STATS_ADD(history, index_probes, 1);
+  return NULL;
+}
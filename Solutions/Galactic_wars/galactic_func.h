@@ -2,20 +2,30 @@
 #define GALACTIC_FUNC_H
 #include <stddef.h>
 
+struct history_arena_t;
+struct string_pool_t;
+struct history_stats_t;
+
 // 1. struct fleet_status_t: Represents the status of a single fleet.
 struct fleet_status_t {
   unsigned char status_flags;   // Bit-encoded fleet status flags. Bit 0: "Ready for Jump", Bit 1: "Shields Active", etc.
   unsigned int total_ships;  // Total number of ships in this fleet.
-  char *fleet_name;            // Name of the fleet (e.g., "Red Squadron").
+  char *fleet_name;            // Name of the fleet (e.g., "Red Squadron"), interned in the history name pool. Exception:
+                               // fleets read by load_galactic_snapshot point into the mapped file and have no pool id.
 };
 
 
 // 2. struct battle_t: Represents a single battle.
 struct battle_t {
-  char *battle_name;           // Name of the battle (e.g., "Battle of Coruscant").
+  char *battle_name;           // Name of the battle (e.g., "Battle of Coruscant"), interned in the history name pool.
+  unsigned int name_id;        // Id of battle_name in the history name pool.
   unsigned int battle_date;    // Date of the battle in YYYYMMDD format.
   struct fleet_status_t **fleet_statuses; // Array of POINTERS to struct fleet_status_t last element must be NULL
   size_t num_fleets;           // Number of fleets in fleet_statuses (excluding the trailing NULL).
+  size_t fleet_capacity;       // Slots allocated in fleet_statuses (including the trailing NULL).
+  unsigned int battle_id;      // Creation ordinal of the battle in its history, used by the fleet store.
+  size_t store_offset;         // First slot of this battle's segment in the history fleet store.
+  size_t store_capacity;       // Slots reserved for this battle in the fleet store.
 };
 
 
@@ -27,20 +37,145 @@ struct battle_node_t {
 };
 
 
-// 4. struct galaxy_history_t: Main structure storing the entire history of wars.
+// 4. struct fleet_store_t: Columnar copy of the fleet data, so scans read packed bytes
+// instead of chasing battle -> fleet pointers. Every battle owns a contiguous segment,
+// fleet i of a battle lives at slot store_offset + i. Unused slots are holes with zero
+// flags and ships, so whole-column scans need no special casing.
+// Fleets must be changed through the functions below to keep the store in sync.
+struct fleet_store_t {
+  unsigned char *status_flags;     // status_flags of every fleet.
+  unsigned int *total_ships;       // total_ships of every fleet.
+  unsigned int *battle_ids;        // battle_id of the owning battle, FLEET_STORE_HOLE for unused slots.
+  size_t size;                     // Slots in use (end of the last segment).
+  size_t capacity;                 // Slots allocated in every column.
+  size_t flag_histogram[256];      // Number of fleets per status_flags value (holes not counted).
+  size_t bit_counts[8];            // Number of fleets with each status bit set.
+  size_t mask_counts[256];         // Cached "any of mask" fleet counts.
+  size_t mask_cached_at[256];      // Generation each mask_counts entry was computed in.
+  size_t generation;               // Bumped by every change, older cache entries are stale.
+  struct history_stats_t *stats;   // Counters of the owning history column growth is charged to, NULL if not counted.
+};
+
+#define FLEET_STORE_HOLE 0xFFFFFFFFu
+
+
+// 5. struct galaxy_history_t: Main structure storing the entire history of wars.
 struct galaxy_history_t {
   struct battle_node_t *head;      // Pointer to the head (beginning) of the battle list.
   struct battle_node_t *tail;      // Pointer to the tail (end) of the battle list.
   size_t total_battles;            // Total number of battles in the system.
+  size_t battles_created;          // Battles ever linked, every one got a distinct battle_id.
+  struct battle_node_t **battle_index; // Open-addressing hash index keyed on (battle_name, battle_date), NULL slots are empty.
+  size_t index_capacity;           // Number of slots in battle_index (always a power of two, or 0 before first insert).
+  struct history_arena_t *arena;   // Optional bump allocator owning nodes, battles and fleets, NULL means plain heap.
+  struct string_pool_t *names;     // Interned battle and fleet names, each distinct name stored once.
+  struct fleet_store_t store;      // Columnar fleet data mirrored from the battles.
+  struct battle_node_t **date_index; // Battles ordered by battle_date: a sorted prefix followed by newly added battles.
+  size_t date_index_count;         // Battles in date_index.
+  size_t date_index_sorted;        // Length of the sorted prefix of date_index.
+  size_t date_index_capacity;      // Slots allocated in date_index.
+  const void *snapshot_map;        // Mapped snapshot file the names point into, NULL if not loaded from one.
+  size_t snapshot_size;            // Size of snapshot_map in bytes.
+  void (*retire)(void *ctx, void *ptr); // Replaces free for blocks concurrent readers may still use, NULL frees at once.
+  void *retire_ctx;                // Passed to retire.
+  size_t unknown_statuses;         // FLEET status fields the loaders did not recognize, reported by main, the stats JSON and snapshots.
+  struct history_stats_t *stats;   // Instrumentation counters (see get_history_stats), NULL unless built with -DGALACTIC_STATS.
+};
+
+
+// 6. struct fleet_status_command_t: One status change for modify_fleet_statuses_batch.
+struct fleet_status_command_t {
+  const char *battle_name;     // Name of the battle to modify.
+  unsigned int date;           // Date of the battle in YYYYMMDD format.
+  int operation_type;          // 0 - set bits (OR), 1 - clear bits (AND NOT), 2 - toggle bits (XOR).
+  unsigned int mask;           // The bitmask to apply the operation with.
+};
+
+
+// 7. struct name_pool_stats_t: Memory used by the interned names of a history.
+struct name_pool_stats_t {
+  size_t names_interned;       // Names handed to the pool (one per battle and fleet created).
+  size_t distinct_names;       // Distinct names stored.
+  size_t bytes_requested;      // Bytes a separate copy of every name would take (text + NUL).
+  size_t bytes_stored;         // Bytes of the pooled copies.
+  size_t table_bytes;          // Bytes of the pool lookup tables.
+};
+
+
+// 8. struct history_stats_t: Instrumentation counters of a history (builds with -DGALACTIC_STATS).
+// Loader phases of phase_ms:
+#define HISTORY_PHASE_READ 0         // Reading or mapping the file.
+#define HISTORY_PHASE_PARSE 1        // Tokenizing records and decoding statuses.
+#define HISTORY_PHASE_BUILD 2        // Battle lookup, name interning, node and fleet creation.
+#define HISTORY_PHASE_MERGE 3        // Merging the pieces of the parallel loader.
+#define HISTORY_PHASES 4
+
+struct history_stats_t {
+  size_t nodes_visited;        // Battle list nodes and date index entries walked.
+  size_t index_probes;         // Battle hash index slots probed by lookups.
+  size_t name_compares;        // Battle key checks in the index plus name compares in the name pool.
+  size_t reallocs;             // Fleet arrays, indexes and store columns resized.
+  size_t bytes_allocated;      // Bytes requested for nodes, battles, fleets, arrays, indexes and the store (names: see name_pool_stats_t).
+  double phase_ms[HISTORY_PHASES]; // Loader time per phase, the parallel loader sums read, parse and build over its threads.
+};
+
+
+// 9. struct fleet_predicate_t: Conditions a fleet must meet all at once in a fleet query.
+// Masks follow count_fleets_with_status_bits: flags are one byte, higher bits never match.
+struct fleet_predicate_t {
+  unsigned int all_mask;       // Every one of these status bits set (0 - no condition).
+  unsigned int none_mask;      // None of these status bits set (0 - no condition).
+  unsigned int any_mask;       // At least one of these status bits set (0 - no condition).
+  unsigned int min_ships;      // total_ships from min_ships ...
+  unsigned int max_ships;      // ... to max_ships, both included.
+  unsigned int date_from;      // Battles dated from date_from ...
+  unsigned int date_to;        // ... to date_to, both included.
+};
+
+
+// 10. struct fleet_query_t: A predicate compiled by compile_fleet_query for the fused scan.
+struct fleet_query_t {
+  unsigned char accept[256];   // 1 for status_flags values meeting the three masks, 0 otherwise.
+  unsigned int min_ships;      // A fleet matches when total_ships - min_ships <= ship_span (unsigned),
+  unsigned int ship_span;      // one compare for both bounds.
+  unsigned int date_from;      // Date range, empty when date_from > date_to.
+  unsigned int date_to;
+  int every_date;              // Range covers every date, the store is scanned without the date index.
+  int every_ship_count;        // Ship range covers every count.
 };
 
 
+// 11. struct fleet_query_result_t: What run_fleet_query found.
+struct fleet_query_result_t {
+  size_t fleets;               // Matching fleets.
+  unsigned long long ships;    // Sum of their total_ships.
+};
+
+
+// Callback for for_each_battle_in_date_range, returning nonzero stops the iteration.
+typedef int (*battle_visitor_t)(const struct battle_t *battle, void *ctx);
+
+// Callback for run_fleet_query, called per matching fleet; returning nonzero stops the query.
+typedef int (*fleet_visitor_t)(const struct battle_t *battle, const struct fleet_status_t *fleet, void *ctx);
+
+
 // Initializes the galaxy_history_t structure.
 // Returns 0 on success, 1 on error (e.g., NULL history_ptr).
 int initialize_history(struct galaxy_history_t **history_ptr);
 
 
+// Initializes the galaxy_history_t structure backed by an arena allocator.
+// Every node, battle and fleet is then bumped from large blocks and
+// destroy_galactic_history releases them at once. Fleets passed to
+// add_fleet_to_battle stay malloc'd and are freed together with the arena.
+// `block_size`: Size of the arena blocks in bytes, 0 picks the default.
+// Returns 0 on success, 1 on error (e.g., NULL history_ptr), 4 on memory allocation error.
+int initialize_history_with_arena(struct galaxy_history_t **history_ptr, size_t block_size);
+
+
 // Loads galactic war history data from a file.
+// The '|'-separated fields after the ship count are statuses, matched exactly ("Shields Active"
+// and "Shield Active" both set bit 1); unrecognized ones are counted in unknown_statuses.
 // `fname`: Path to the file.
 // `history_ptr`: Pointer to a pointer to the galaxy_history_t structure, which will be
 //                initialized and populated with data.
@@ -49,19 +184,121 @@ int initialize_history(struct galaxy_history_t **history_ptr);
 int load_galactic_history(const char *fname, struct galaxy_history_t **history_ptr);
 
 
+// Loads galactic war history data by mapping the file and tokenizing it in place.
+// Same format, merge rules and return codes as load_galactic_history, but without
+// per-line copies and without the 57 character limit on names.
+// `fname`: Path to the file.
+// `history_ptr`: Pointer to a pointer to an initialized galaxy_history_t structure.
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening error,
+//          3 - corrupted file format, 4 - memory allocation error.
+int load_galactic_history_mmap(const char *fname, struct galaxy_history_t **history_ptr);
+
+
+// Loads galactic war history data on several threads. The file is split at BATTLE: lines,
+// the pieces are parsed in parallel and merged in file order, so the result is identical
+// to load_galactic_history. Arena-backed histories are loaded on the calling thread.
+// `nthreads`: Maximum number of threads to use (small files use fewer).
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening error,
+//          3 - corrupted file format, 4 - memory allocation error.
+int load_galactic_history_parallel(const char *fname, struct galaxy_history_t **history_ptr, int nthreads);
+
+
+// Saves a versioned binary snapshot of the history: a string table with every distinct
+// name once, fixed-width battle records and packed fleet records, plus a checksum. The
+// unknown_statuses count is kept in the header.
+// `history`: Pointer to the galaxy_history_t structure.
+// `fname`: Path to the snapshot file (overwritten).
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening/writing error,
+//          3 - history too big for the format, 4 - memory allocation error.
+int save_galactic_snapshot(const struct galaxy_history_t *history, const char *fname);
+
+
+// Loads a snapshot written by save_galactic_snapshot. The file is mapped and validated,
+// names are used in place (battle names are interned as external names of the pool, fleet
+// names are not interned at all), so the history keeps the mapping until it is destroyed.
+// `history_ptr`: Pointer to NULL (an arena-backed history is created) or to an empty
+//                history initialized with initialize_history_with_arena.
+// Returns: 0 - success, 1 - invalid input, 2 - file opening error,
+//          3 - corrupted or foreign snapshot, 4 - memory allocation error.
+int load_galactic_snapshot(const char *fname, struct galaxy_history_t **history_ptr);
+
+
+// Saves the history in the BATTLE:/DATE:/FLEET: text format, oldest battle first, so
+// load_galactic_history reads back the same battles in the same order. Output goes
+// through a large buffer (a small one if it cannot be allocated) and numbers are formatted
+// without stdio.
+// `history`: Pointer to the galaxy_history_t structure.
+// `fname`: Path to the file (overwritten).
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening/writing error.
+int save_galactic_history(const struct galaxy_history_t *history, const char *fname);
+
+
 // Displays all battle data in the system.
 // `history`: Pointer to the galaxy_history_t structure.
 void display_galactic_history(const struct galaxy_history_t *history);
 
 
 // Bitwise operation function: Returns the count of fleets that have at least one of the
-// specified status bits set.
+// specified status bits set. Answered from counters kept up to date by every mutation:
+// single bits in O(1), other masks in O(256) after a change and O(1) when repeated.
+// Building with GALACTIC_DEBUG_COUNTERS cross-checks every answer against a full traversal of
+// the battle list. Several threads may call it at once while nobody modifies the history (the
+// mask cache is updated atomically); readers running next to a writer use galactic_concurrent.h.
 // `history`: Pointer to the galaxy_history_t structure.
 // `mask`: The bitmask to check against.
 // Returns: The count of fleets meeting the criteria, -1 on error (e.g., NULL history).
 int count_fleets_with_status_bits(const struct galaxy_history_t *history, unsigned int mask);
 
 
+// Returns the sum of total_ships over fleets that have at least one of the specified
+// status bits set.
+// `history`: Pointer to the galaxy_history_t structure.
+// `mask`: The bitmask to check against.
+// Returns: The sum of ships, -1 on error (e.g., NULL history).
+long long sum_ships_with_status_bits(const struct galaxy_history_t *history, unsigned int mask);
+
+
+// Bitwise operation function: Returns the count of fleets that have at least one of the
+// specified status bits set, in battles dated from `date_from` to `date_to` (both included).
+// Battles are found through the date index in O(log N + k); battles added since the
+// previous range query are sorted in first, which is why the history is not const.
+// Returns: The count of fleets meeting the criteria, -1 on error (e.g., NULL history).
+int count_fleets_with_status_bits_in_date_range(struct galaxy_history_t *history, unsigned int mask, unsigned int date_from, unsigned int date_to);
+
+
+// Calls `visitor` for every battle dated from `date_from` to `date_to` (both included),
+// in date order (equal dates in the order the battles were added).
+// `ctx`: Passed through to the visitor.
+// Returns: The number of battles visited, -1 on error (e.g., NULL history or visitor).
+int for_each_battle_in_date_range(struct galaxy_history_t *history, unsigned int date_from, unsigned int date_to, battle_visitor_t visitor, void *ctx);
+
+
+// Fills `predicate` so every fleet meets it: no mask conditions, every ship count and date.
+// Callers set the fields they need afterwards.
+void init_fleet_predicate(struct fleet_predicate_t *predicate);
+
+
+// Compiles `predicate` into `query`: the three masks become one 256-entry table indexed by
+// status_flags, the ranges single unsigned compares. A query can be run any number of times.
+// Returns: 0 - success, 1 - invalid input (NULL).
+int compile_fleet_query(const struct fleet_predicate_t *predicate, struct fleet_query_t *query);
+
+
+// Runs a compiled query in one pass without allocating. Without a date range and visitor the
+// columnar fleet store is scanned straight through; otherwise battles come from the date index
+// (in date order, like for_each_battle_in_date_range) and each one's store segment is scanned.
+// `result`: Receives the number of matching fleets and the sum of their ships.
+// `visitor`: Optional, called with every matching fleet (in battle order within a battle).
+// Returns: 0 - success, 1 - invalid input (NULL history, query or result).
+int run_fleet_query(struct galaxy_history_t *history, const struct fleet_query_t *query, struct fleet_query_result_t *result, fleet_visitor_t visitor, void *ctx);
+
+
+// Counts the fleets matching a compiled query. Queries on flags alone are answered from the
+// flag histogram of the store in O(256), others by run_fleet_query.
+// Returns: The count of matching fleets, -1 on error (e.g., NULL history).
+int count_fleets_matching(struct galaxy_history_t *history, const struct fleet_query_t *query);
+
+
 // Bitwise operation function: Modifies the status of all fleets within a given battle.
 // `history`: Pointer to the galaxy_history_t structure.
 // `battle_name`: The name of the battle to find.
@@ -71,11 +308,65 @@ int count_fleets_with_status_bits(const struct galaxy_history_t *history, unsign
 int modify_fleet_statuses_in_battle(struct galaxy_history_t *history, const char *battle_name, unsigned int date, int operation_type, unsigned int mask);
 
 
+// Looks up a battle by its (name, date) key through the history hash index.
+// `history`: Pointer to the galaxy_history_t structure.
+// Returns: The node holding the battle, or NULL if not found or on invalid input.
+struct battle_node_t *find_battle_node(const struct galaxy_history_t *history, const char *battle_name, unsigned int date);
+
+
+// Bitwise operation function: Applies many status changes in one call. Commands run in
+// order, each battle is found through the hash index and nothing is printed.
+// `history`: Pointer to the galaxy_history_t structure.
+// `commands`: Array of `count` status changes.
+// `results`: Array of `count` ints receiving, per command, the number of fleets modified
+//            or -1 if the battle was not found or the operation type is unknown.
+// Returns: The number of commands applied, -1 on invalid input.
+int modify_fleet_statuses_batch(struct galaxy_history_t *history, const struct fleet_status_command_t *commands, size_t count, int *results);
+
+
+// Gives back the unused fleet_statuses slots of every battle. Arrays grow geometrically,
+// so after loading or adding fleets up to half of the slots can be spare. Arena-backed
+// and concurrently shared histories keep their arrays (old blocks cannot be reused there).
+// `history`: Pointer to the galaxy_history_t structure.
+// Returns: 0 - success, 1 - invalid input (NULL), 4 - memory allocation error.
+int shrink_fleet_statuses_to_fit(struct galaxy_history_t *history);
+
+
+// Reports how much memory interning saves on the names of the history.
+// Returns: 0 - success, 1 - invalid input (NULL).
+int get_name_pool_stats(const struct galaxy_history_t *history, struct name_pool_stats_t *stats);
+
+
+// Copies the instrumentation counters of the history, accumulated since it was initialized.
+// Without -DGALACTIC_STATS nothing is counted (at no cost) and `stats` is zeroed.
+// Returns: 0 - success, 1 - invalid input (NULL), 5 - built without GALACTIC_STATS.
+int get_history_stats(const struct galaxy_history_t *history, struct history_stats_t *stats);
+
+
+// Writes the counters of get_history_stats and unknown_statuses as one JSON object.
+// `fname`: Path to the file (overwritten).
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening/writing error,
+//          5 - built without GALACTIC_STATS.
+int save_history_stats_json(const struct galaxy_history_t *history, const char *fname);
+
+
 // Frees all memory allocated for the galactic war history system.
 // `history_ptr`: Pointer to a pointer to the galaxy_history_t structure.
 void destroy_galactic_history(struct galaxy_history_t **history_ptr);
 
+// Adds a fleet to a battle. The history takes ownership of the fleet, its name is interned
+// and the caller's copy of the name freed (fleet_name then points into the name pool, in
+// snapshot histories too).
 // Returns: 0 on success, 1 on invalid input, 2 - battle not found, 4 - memory allocation failure
 int add_fleet_to_battle(struct galaxy_history_t *history, const char *battle_name,unsigned int date, struct fleet_status_t *new_fleet);
 
+// Adds `count` fleets to one battle, in array order, with a single lookup and a single
+// reservation. The history takes ownership of all fleets on success and of none on failure,
+// the battle is left unchanged then (names seen for the first time stay in the pool, counted in
+// distinct_names and bytes_stored but not in names_interned and bytes_requested).
+// `fleets`: Array of `count` distinct heap-allocated fleets, names are interned like in add_fleet_to_battle.
+// Returns: 0 on success, 1 on invalid input (e.g., a NULL fleet or one listed twice),
+//          2 - battle not found, 4 - memory allocation failure
+int add_fleets_to_battle(struct galaxy_history_t *history, const char *battle_name, unsigned int date, struct fleet_status_t **fleets, size_t count);
+
 #endif //GALACTIC_FUNC_H
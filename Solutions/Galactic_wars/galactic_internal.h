@@ -0,0 +1,117 @@
+#ifndef GALACTIC_INTERNAL_H
+#define GALACTIC_INTERNAL_H
+#include "galactic_func.h"
+#include <stddef.h>
+#include <stdio.h>
+
+// Helpers shared by the galactic_func*.c files, not part of the public API.
+
+// State of the loader while it fills battles from a file
+struct history_loader_t {
+  struct galaxy_history_t *history;
+  struct battle_node_t *current;   // Battle receiving FLEET lines
+};
+
+
+// Status flags from the status fields of the FLEET line[0, len), fields naming no
+// status are counted in `unknown` (optional)
+unsigned char set_fleet_status_n(const char *line, size_t len, size_t *unknown);
+
+// Allocation through the history arena when it has one, plain heap otherwise
+void *history_alloc(struct galaxy_history_t *history, size_t size);
+void history_free(struct galaxy_history_t *history, void *ptr);
+void *history_realloc(struct galaxy_history_t *history, void *ptr, size_t used_bytes, size_t new_bytes);
+
+// Nodes and fleets allocated through the helpers above, names interned in history->names
+struct battle_node_t *create_new_battle(struct galaxy_history_t *history, unsigned int name_id, unsigned int battle_date);
+void free_battle_node(struct galaxy_history_t *history, struct battle_node_t *node);
+struct fleet_status_t *create_fleet_statuse(struct galaxy_history_t *history, const char *fleet_name, size_t name_len, unsigned int total_ships, unsigned int status_flag);
+
+// Battle list and hash index maintenance, return 0 on success, 4 on memory allocation error
+int pushfront_node(struct galaxy_history_t *history, struct battle_node_t *current_battle);
+int set_battle_date(struct galaxy_history_t *history, struct battle_node_t *node, unsigned int battle_date);
+struct battle_node_t *find_battle_node_n(const struct galaxy_history_t *history, const char *battle_name, size_t name_len, unsigned int date);
+struct battle_node_t *find_battle_node_id(const struct galaxy_history_t *history, unsigned int name_id, unsigned int date);
+
+// Fleet array capacity, return 0 on success, 4 on memory allocation error (battle unchanged then)
+int battle_reserve_fleets(struct galaxy_history_t *history, struct battle_t *battle, size_t needed);
+int battle_shrink_to_fit(struct galaxy_history_t *history, struct battle_t *battle);
+
+// Loader steps, return 0 on success, 4 on memory allocation error
+int loader_switch_battle(struct history_loader_t *loader, const char *battle_name, size_t name_len, unsigned int battle_date);
+int loader_append_fleet(struct history_loader_t *loader, struct fleet_status_t *fleet);
+int loader_set_date(struct history_loader_t *loader, unsigned int battle_date);
+
+// Parses a whole galactic_data buffer into history (galactic_mmap.c)
+// `late_dates`: Optional counter of DATE records that re-dated a battle filled before them.
+// Returns: 0 - success, 3 - corrupted file format, 4 - memory allocation error.
+int parse_galactic_buffer(const char *data, size_t size, struct galaxy_history_t *history, size_t *late_dates);
+
+// Read-only mapping of a whole file, returns 0 on success, 2 on file opening error
+int map_galactic_file(const char *fname, const char **data, size_t *size);
+void unmap_galactic_file(const char *data, size_t size);
+
+// Date index maintenance (galactic_dates.c), returns 0 on success, 4 on memory allocation error
+int date_index_append(struct galaxy_history_t *history, struct battle_node_t *node);
+
+// Drops a battle from the date index, keeping the order of the others
+void date_index_remove(struct galaxy_history_t *history, struct battle_node_t *node);
+
+// Sorts battles added since the last range query into the date index
+void date_index_settle(struct galaxy_history_t *history);
+
+// Position of the first battle dated `date` or later in a settled date index
+size_t date_index_lower_bound(const struct galaxy_history_t *history, unsigned int date);
+
+// Unmaps the snapshot file a history was loaded from (galactic_snapshot.c)
+void release_snapshot_mapping(struct galaxy_history_t *history);
+
+// Instrumentation (galactic_stats.c). With -DGALACTIC_STATS the macros bump history->stats,
+// otherwise they compile to nothing. Counters are added atomically since concurrent readers
+// display through the same code; loader phase clocks belong to the single loading thread.
+#ifdef GALACTIC_STATS
+// Phase being timed and when it was entered, phase HISTORY_PHASES is not charged
+struct stats_clock_t {
+  double start;
+  int phase;
+};
+
+double stats_now_ms(void);
+void stats_enter_phase(struct history_stats_t *stats, struct stats_clock_t *clock, int phase);
+void stats_accumulate(struct galaxy_history_t *history, const struct galaxy_history_t *partial);
+
+#define STATS_ADD(history, field, n) ((void) __atomic_fetch_add(&(history)->stats->field, (size_t) (n), __ATOMIC_RELAXED))
+#define STATS_CLOCK(clock, phase) struct stats_clock_t clock = {stats_now_ms(), (phase)}
+#define STATS_PHASE(history, clock, phase) stats_enter_phase((history)->stats, &(clock), (phase))
+#define STATS_ACCUMULATE(history, partial) stats_accumulate((history), (partial))
+#else
+#define STATS_ADD(history, field, n) ((void) 0)
+#define STATS_CLOCK(clock, phase) ((void) 0)
+#define STATS_PHASE(history, clock, phase) ((void) 0)
+#define STATS_ACCUMULATE(history, partial) ((void) 0)
+#endif
+
+// Buffered text emitter (galactic_writer.c)
+#define WRITER_FALLBACK_SIZE 512
+
+struct history_writer_t {
+  FILE *file;
+  char *buffer;                    // Heap buffer, or fallback when it could not be allocated
+  size_t capacity;                 // Bytes of buffer
+  size_t len;                      // Bytes waiting in buffer
+  int error;                       // Set once a write to file failed
+  char fallback[WRITER_FALLBACK_SIZE];
+};
+
+extern const char *const status_bit_names[4];
+
+// Opening cannot fail: without memory for the large buffer the small inline one is used
+void writer_open(struct history_writer_t *writer, FILE *file);
+int writer_close(struct history_writer_t *writer);
+void writer_flush(struct history_writer_t *writer);
+void writer_put(struct history_writer_t *writer, const char *data, size_t len);
+void writer_puts(struct history_writer_t *writer, const char *str);
+void writer_putc(struct history_writer_t *writer, char c);
+void writer_put_number(struct history_writer_t *writer, unsigned long long value);
+
+#endif //GALACTIC_INTERNAL_H
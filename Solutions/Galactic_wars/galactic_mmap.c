@@ -0,0 +1,192 @@
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Zero-copy loader: the file is mapped and records are tokenized in place.
+// Accepts the same format as load_galactic_history, without its 57 character name limit.
+
+
+// Parses an unsigned number the way sscanf("%u") does (leading spaces, optional sign)
+// Returns pointer past the number, or NULL if there are no digits
+const char *scan_unsigned(const char *p, const char *end, unsigned int *value){
+  while (p < end && isspace((unsigned char) *p)) p++;
+
+  int negative = 0;
+  if (p < end && (*p == '+' || *p == '-')){
+    negative = *p == '-';
+    p++;
+  }
+  if (p == end || !isdigit((unsigned char) *p)) return NULL;
+
+  unsigned int result = 0;
+  while (p < end && isdigit((unsigned char) *p)) result = result * 10 + (unsigned int) (*p++ - '0');
+
+  *value = negative ? 0u - result : result;
+  return p;
+}
+
+
+// Splits "name|<int>|<ships>|..." after the FLEET: prefix
+// Returns 1 on success, 0 on malformed record
+int scan_fleet_record(const char *p, const char *end, const char **name, size_t *name_len, unsigned int *total_ships){
+  const char *bar = (const char *) memchr(p, '|', (size_t) (end - p));
+  if (!bar || bar == p) return 0;
+  *name = p;
+  *name_len = (size_t) (bar - p);
+
+  // Second field is always 0 and skipped
+  unsigned int skipped;
+  p = scan_unsigned(bar + 1, end, &skipped);
+  if (!p || p == end || *p != '|') return 0;
+
+  return scan_unsigned(p + 1, end, total_ships) != NULL;
+}
+
+
+// Parses data[0, size) into history, the same state machine as load_galactic_history
+// `late_dates`: Optional counter of DATE records that re-dated a battle filled before them
+// Returns: 0 - success, 3 - corrupted file format, 4 - memory allocation error.
+int parse_galactic_buffer(const char *data, size_t size, struct galaxy_history_t *history, size_t *late_dates){
+  const char *p = data;
+  const char *end = data + size;
+
+  struct history_loader_t loader = {history, NULL};
+  const char *battle_name = NULL;
+  size_t battle_len = 0;
+  int pending = 0; // BATTLE record read but its node is not resolved yet (waits for the DATE record)
+  int res = 0;
+
+  STATS_CLOCK(clock, HISTORY_PHASE_PARSE);
+  while (p < end && !res){
+    STATS_PHASE(history, clock, HISTORY_PHASE_PARSE);
+    const char *eol = (const char *) memchr(p, '\n', (size_t) (end - p));
+    if (!eol) eol = end;
+    size_t len = (size_t) (eol - p);
+
+    // Like the fgets loader, the first empty line ends the data
+    if (!len && eol < end) break;
+
+    const char *fleet_name;
+    size_t fleet_len;
+    unsigned int value;
+
+    if (len >= 7 && memcmp(p, "BATTLE:", 7) == 0){
+      // Battle without DATE and fleets is still kept, dated 0
+      if (pending && (res = loader_switch_battle(&loader, battle_name, battle_len, 0)) != 0) break;
+      if (len == 7){
+        res = 3; // Malformed BATTLE record
+        break;
+      }
+      battle_name = p + 7;
+      battle_len = len - 7;
+      pending = 1;
+    }
+    else if (len >= 5 && memcmp(p, "DATE:", 5) == 0 && scan_unsigned(p + 5, eol, &value)){
+      if (!pending && !loader.current){
+        res = 3; // Corrupted file: DATE without BATTLE
+        break;
+      }
+      STATS_PHASE(history, clock, HISTORY_PHASE_BUILD);
+      if (!pending && loader.current->battle->battle_date == 0){
+        res = loader_set_date(&loader, value);
+        if (late_dates) (*late_dates)++;
+      } else {
+        res = loader_switch_battle(&loader, battle_name, battle_len, value);
+        pending = 0;
+      }
+    }
+    else if (len >= 6 && memcmp(p, "FLEET:", 6) == 0 && scan_fleet_record(p + 6, eol, &fleet_name, &fleet_len, &value)){
+      unsigned char status_flags = set_fleet_status_n(p, len, &history->unknown_statuses);
+      STATS_PHASE(history, clock, HISTORY_PHASE_BUILD);
+
+      if (pending){
+        if ((res = loader_switch_battle(&loader, battle_name, battle_len, 0)) != 0) break;
+        pending = 0;
+      }
+      if (!loader.current){
+        res = 3; // Corrupted file: FLEET without BATTLE
+        break;
+      }
+
+      struct fleet_status_t *fleet = create_fleet_statuse(history, fleet_name, fleet_len, value, status_flags);
+      if (!fleet){
+        res = 4;
+        break;
+      }
+      if ((res = loader_append_fleet(&loader, fleet)) != 0){
+        history_free(history, fleet);
+      }
+    }
+    // Anything else longer than a lone character (newline included) is corrupted
+    else if (len + (eol < end) > 1){
+      res = 3;
+    }
+
+    p = eol + 1;
+  }
+
+  if (!res && pending){
+    STATS_PHASE(history, clock, HISTORY_PHASE_BUILD);
+    res = loader_switch_battle(&loader, battle_name, battle_len, 0);
+  }
+  STATS_PHASE(history, clock, HISTORY_PHASES);
+  return res;
+}
+
+
+// Maps the whole file read-only, an empty file gives a NULL mapping of size 0
+// Returns 0 on success, 2 on file opening error
+int map_galactic_file(const char *fname, const char **data, size_t *size){
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0) return 2;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0){
+    close(fd);
+    return 2;
+  }
+  *data = NULL;
+  *size = (size_t) st.st_size;
+  if (!*size){
+    close(fd);
+    return 0;
+  }
+
+  void *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 2;
+
+  madvise(map, *size, MADV_SEQUENTIAL);
+  *data = (const char *) map;
+  return 0;
+}
+
+
+void unmap_galactic_file(const char *data, size_t size){
+  if (data) munmap((void *) data, size);
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening error,
+//          3 - corrupted file format, 4 - memory allocation error.
+int load_galactic_history_mmap(const char *fname, struct galaxy_history_t **history_ptr){
+  if (!fname || !history_ptr || !*history_ptr) return 1;
+
+  // File handling
+  const char *data;
+  size_t size;
+  STATS_CLOCK(clock, HISTORY_PHASE_READ);
+  if (map_galactic_file(fname, &data, &size) != 0) return 2;
+  STATS_PHASE(*history_ptr, clock, HISTORY_PHASES);
+
+  int res = parse_galactic_buffer(data, size, *history_ptr, NULL);
+
+  unmap_galactic_file(data, size);
+  if (res) destroy_galactic_history(history_ptr);
+  return res;
+}
@@ -0,0 +1,236 @@
+#define _GNU_SOURCE // memmem
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include "fleet_store.h"
+#include "string_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Parallel loader: the mapped file is cut at BATTLE: lines, every piece is parsed into
+// its own partial history on a worker thread and the partials are merged in file order.
+// Needs linking with -pthread.
+
+#define PARALLEL_MIN_CHUNK (64 * 1024)  // Smaller pieces are not worth a thread
+#define PARALLEL_MAX_THREADS 64
+
+
+// One piece of the file and the partial history parsed from it
+struct parse_chunk_t {
+  const char *data;
+  size_t size;
+  struct galaxy_history_t *partial;
+  size_t late_dates;
+  int res;
+};
+
+
+void *parse_chunk_worker(void *arg){
+  struct parse_chunk_t *chunk = (struct parse_chunk_t *) arg;
+  chunk->res = parse_galactic_buffer(chunk->data, chunk->size, chunk->partial, &chunk->late_dates);
+  return NULL;
+}
+
+
+// End of the data the serial loader reads: it stops at the first empty line
+size_t effective_size(const char *data, size_t size){
+  if (!size || data[0] == '\n') return 0;
+
+  const char *blank = (const char *) memmem(data, size, "\n\n", 2);
+  return blank ? (size_t) (blank - data) + 1 : size;
+}
+
+
+// First line start at or after `pos` that begins with BATTLE:, or `size`
+size_t next_battle_boundary(const char *data, size_t size, size_t pos){
+  if (pos >= size) return size;
+
+  const char *hit = (const char *) memmem(data + pos, size - pos, "\nBATTLE:", 8);
+  return hit ? (size_t) (hit - data) + 1 : size;
+}
+
+
+// Removes the oldest battle (tail) from a partial history
+struct battle_node_t *take_oldest_battle(struct galaxy_history_t *partial){
+  struct battle_node_t *node = partial->tail;
+  if (!node) return NULL;
+
+  partial->tail = node->prev;
+  if (partial->tail) partial->tail->next = NULL;
+  else partial->head = NULL;
+  node->prev = NULL;
+  node->next = NULL;
+  return node;
+}
+
+
+// Puts a battle back as the oldest one, so the partial frees it on destroy
+void return_oldest_battle(struct galaxy_history_t *partial, struct battle_node_t *node){
+  node->prev = partial->tail;
+  node->next = NULL;
+  if (partial->tail) partial->tail->next = node;
+  else partial->head = node;
+  partial->tail = node;
+}
+
+
+// Copies the fleets of `battle` (index from..num_fleets) into its segment of the history store
+void store_battle_fleets(struct galaxy_history_t *history, struct battle_t *battle, size_t from){
+  for (size_t i = from; i < battle->num_fleets; ++i){
+    struct fleet_status_t *fleet = battle->fleet_statuses[i];
+    fleet_store_set(&history->store, battle, i, fleet->status_flags, fleet->total_ships);
+  }
+}
+
+
+// Points the names of a battle moving out of a partial at the history pool
+void forward_battle_names(struct galaxy_history_t *history, struct battle_t *battle, const unsigned int *forward){
+  battle->name_id = forward[battle->name_id];
+  battle->battle_name = (char *) history->names->entries[battle->name_id].str;
+  for (size_t i = 0; i < battle->num_fleets; ++i){
+    struct fleet_status_t *fleet = battle->fleet_statuses[i];
+    fleet->fleet_name = (char *) history->names->entries[forward[string_pool_id_of(fleet->fleet_name)]].str;
+  }
+}
+
+
+// Moves every battle of `partial` into `history`, oldest first, merging equal (name, date) keys
+// the way the serial loader does. Returns 0 on success, 1 if partial was loaded from a snapshot,
+// 4 on memory allocation error.
+int merge_partial_history(struct galaxy_history_t *history, struct galaxy_history_t *partial){
+  // Fleet names are remapped by their pool id, snapshot fleet names have none
+  if (partial->snapshot_map) return 1;
+
+  // Distinct names are interned once, every moved name is then remapped by id
+  unsigned int *forward = (unsigned int *) malloc((partial->names->count ? partial->names->count : 1) * sizeof(unsigned int));
+  if (!forward) return 4;
+  if (string_pool_merge(history->names, partial->names, forward) != 0){
+    free(forward);
+    return 4;
+  }
+  history->unknown_statuses += partial->unknown_statuses;
+
+  int res = 0;
+  struct battle_node_t *node;
+  while (!res && (node = take_oldest_battle(partial)) != NULL){
+    struct battle_t *battle = node->battle;
+    forward_battle_names(history, battle, forward);
+    struct battle_node_t *existing = find_battle_node_id(history, battle->name_id, battle->battle_date);
+
+    if (!existing){
+      // Whole node moves over, only its store segment is rebuilt in the target store
+      battle->store_offset = 0;
+      battle->store_capacity = 0;
+      if (fleet_store_reserve(&history->store, battle, battle->num_fleets) != 0 || pushfront_node(history, node) != 0){
+        return_oldest_battle(partial, node);
+        res = 4;
+        break;
+      }
+      history->total_battles++;
+      store_battle_fleets(history, battle, 0);
+      continue;
+    }
+
+    // Same key already loaded: its fleets are appended in file order. The serial loader
+    // would not have interned the name again, so the pool counters forget this one.
+    struct battle_t *target = existing->battle;
+    history->names->interned--;
+    history->names->bytes_requested -= history->names->entries[target->name_id].len + 1;
+    size_t total = target->num_fleets + battle->num_fleets;
+    if (fleet_store_reserve(&history->store, target, total) != 0 || battle_reserve_fleets(history, target, total) != 0){
+      return_oldest_battle(partial, node);
+      res = 4;
+      break;
+    }
+    memcpy(target->fleet_statuses + target->num_fleets, battle->fleet_statuses, battle->num_fleets * sizeof(struct fleet_status_t *));
+    size_t from = target->num_fleets;
+    target->num_fleets = total;
+    target->fleet_statuses[total] = NULL;
+    store_battle_fleets(history, target, from);
+
+    // Fleets now belong to the target, the emptied node is freed
+    battle->num_fleets = 0;
+    free_battle_node(partial, node);
+  }
+
+  free(forward);
+  return res;
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening error,
+//          3 - corrupted file format, 4 - memory allocation error.
+int load_galactic_history_parallel(const char *fname, struct galaxy_history_t **history_ptr, int nthreads){
+  if (!fname || !history_ptr || !*history_ptr) return 1;
+
+  // Merging moves heap nodes between histories, arena histories (snapshot ones too) load serially
+  if ((*history_ptr)->arena || (*history_ptr)->snapshot_map || nthreads <= 1) return load_galactic_history_mmap(fname, history_ptr);
+
+  const char *data;
+  size_t mapped;
+  STATS_CLOCK(clock, HISTORY_PHASE_READ);
+  if (map_galactic_file(fname, &data, &mapped) != 0) return 2;
+  STATS_PHASE(*history_ptr, clock, HISTORY_PHASES);
+  size_t size = effective_size(data, mapped);
+
+  // Cut the data into at most nthreads pieces at BATTLE: lines
+  if (nthreads > PARALLEL_MAX_THREADS) nthreads = PARALLEL_MAX_THREADS;
+  if ((size_t) nthreads > size / PARALLEL_MIN_CHUNK) nthreads = (int) (size / PARALLEL_MIN_CHUNK);
+  if (nthreads < 1) nthreads = 1;
+
+  struct parse_chunk_t chunks[PARALLEL_MAX_THREADS];
+  int count = 0;
+  size_t start = 0;
+  for (int i = 0; i < nthreads && start < size; ++i){
+    size_t stop = i == nthreads - 1 ? size : next_battle_boundary(data, size, start + (size - start) / (size_t) (nthreads - i));
+    chunks[count].data = data + start;
+    chunks[count].size = stop - start;
+    chunks[count].partial = NULL;
+    chunks[count].late_dates = 0;
+    chunks[count].res = initialize_history(&chunks[count].partial);
+    count++;
+    start = stop;
+  }
+
+  // First chunk is parsed on this thread
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  int started[PARALLEL_MAX_THREADS] = {0};
+  for (int i = 1; i < count; ++i){
+    if (chunks[i].res) continue;
+    started[i] = pthread_create(&threads[i], NULL, parse_chunk_worker, &chunks[i]) == 0;
+    if (!started[i]) parse_chunk_worker(&chunks[i]);
+  }
+  if (count && !chunks[0].res) parse_chunk_worker(&chunks[0]);
+  for (int i = 1; i < count; ++i){
+    if (started[i]) pthread_join(threads[i], NULL);
+  }
+
+  // The first error in file order wins, like in the serial loader
+  int res = 0;
+  size_t late_dates = 0;
+  for (int i = 0; i < count && !res; ++i){
+    res = chunks[i].res;
+    late_dates += chunks[i].late_dates;
+  }
+
+  // A DATE after fleets re-dates whatever battle the serial loader merged them into,
+  // which can live in an earlier piece, so such files are loaded serially
+  if (!res && late_dates){
+    for (int i = 0; i < count; ++i) destroy_galactic_history(&chunks[i].partial);
+    unmap_galactic_file(data, mapped);
+    return load_galactic_history_mmap(fname, history_ptr);
+  }
+
+  STATS_PHASE(*history_ptr, clock, HISTORY_PHASE_MERGE);
+  for (int i = 0; i < count && !res; ++i){
+    res = merge_partial_history(*history_ptr, chunks[i].partial);
+    // Work done on the pieces counts as if done on the merged history
+    STATS_ACCUMULATE(*history_ptr, chunks[i].partial);
+  }
+  STATS_PHASE(*history_ptr, clock, HISTORY_PHASES);
+
+  for (int i = 0; i < count; ++i) destroy_galactic_history(&chunks[i].partial);
+  unmap_galactic_file(data, mapped);
+  if (res) destroy_galactic_history(history_ptr);
+  return res;
+}
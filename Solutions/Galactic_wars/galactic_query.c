@@ -0,0 +1,137 @@
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include <limits.h>
+
+// Fleet queries: a predicate is compiled once into a table over the 256 status_flags values
+// plus two range checks, so matching a fleet is one lookup and one compare however many
+// conditions the predicate has. Scans read the packed columns of the fleet store.
+
+
+void init_fleet_predicate(struct fleet_predicate_t *predicate){
+  if (!predicate) return;
+
+  predicate->all_mask = 0;
+  predicate->none_mask = 0;
+  predicate->any_mask = 0;
+  predicate->min_ships = 0;
+  predicate->max_ships = UINT_MAX;
+  predicate->date_from = 0;
+  predicate->date_to = UINT_MAX;
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL).
+int compile_fleet_query(const struct fleet_predicate_t *predicate, struct fleet_query_t *query){
+  if (!predicate || !query) return 1;
+
+  // A required bit above the flag byte can never be set, an empty ship range never matches
+  int possible = !(predicate->all_mask & ~0xFFu) && predicate->min_ships <= predicate->max_ships;
+  unsigned int all = predicate->all_mask & 0xFFu;
+  unsigned int none = predicate->none_mask & 0xFFu;
+  unsigned int any = predicate->any_mask;
+
+  for (unsigned int flags = 0; flags < 256; ++flags){
+    int match = possible && (flags & all) == all && !(flags & none) && (!any || (flags & any));
+    query->accept[flags] = (unsigned char) match;
+  }
+
+  query->min_ships = predicate->min_ships;
+  query->ship_span = predicate->max_ships - predicate->min_ships;
+  query->date_from = predicate->date_from;
+  query->date_to = predicate->date_to;
+  query->every_date = predicate->date_from == 0 && predicate->date_to == UINT_MAX;
+  query->every_ship_count = predicate->min_ships == 0 && predicate->max_ships == UINT_MAX;
+  return 0;
+}
+
+
+// Fused scan of `count` store slots, adding matches to result. `battle_ids` is only passed
+// for ranges that may contain holes. The loop has no branches on the data.
+void query_scan(const struct fleet_query_t *query, const unsigned char *flags, const unsigned int *ships, const unsigned int *battle_ids, size_t count, struct fleet_query_result_t *result){
+  size_t fleets = 0;
+  unsigned long long sum = 0;
+
+  if (battle_ids){
+    for (size_t i = 0; i < count; ++i){
+      size_t match = (size_t) query->accept[flags[i]] & (ships[i] - query->min_ships <= query->ship_span) & (battle_ids[i] != FLEET_STORE_HOLE);
+      fleets += match;
+      sum += ships[i] & (0ULL - match);
+    }
+  } else {
+    for (size_t i = 0; i < count; ++i){
+      size_t match = (size_t) query->accept[flags[i]] & (ships[i] - query->min_ships <= query->ship_span);
+      fleets += match;
+      sum += ships[i] & (0ULL - match);
+    }
+  }
+
+  result->fleets += fleets;
+  result->ships += sum;
+}
+
+
+// Same scan over one battle's segment, calling the visitor per match
+// Returns nonzero if the visitor stopped the query
+int query_scan_visit(const struct fleet_query_t *query, const struct galaxy_history_t *history, const struct battle_t *battle, struct fleet_query_result_t *result, fleet_visitor_t visitor, void *ctx){
+  const unsigned char *flags = history->store.status_flags + battle->store_offset;
+  const unsigned int *ships = history->store.total_ships + battle->store_offset;
+
+  for (size_t i = 0; i < battle->num_fleets; ++i){
+    if (!query->accept[flags[i]] || ships[i] - query->min_ships > query->ship_span) continue;
+
+    result->fleets++;
+    result->ships += ships[i];
+    if (visitor(battle, battle->fleet_statuses[i], ctx) != 0) return 1;
+  }
+  return 0;
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL history, query or result).
+int run_fleet_query(struct galaxy_history_t *history, const struct fleet_query_t *query, struct fleet_query_result_t *result, fleet_visitor_t visitor, void *ctx){
+  if (!history || !query || !result) return 1;
+
+  result->fleets = 0;
+  result->ships = 0;
+  const struct fleet_store_t *store = &history->store;
+
+  // Whole store in one pass, holes are told apart by their battle id
+  if (query->every_date && !visitor){
+    query_scan(query, store->status_flags, store->total_ships, store->battle_ids, store->size, result);
+    return 0;
+  }
+  if (query->date_from > query->date_to) return 0;
+
+  date_index_settle(history);
+  for (size_t i = date_index_lower_bound(history, query->date_from); i < history->date_index_count; ++i){
+    const struct battle_t *battle = history->date_index[i]->battle;
+    if (battle->battle_date > query->date_to) break;
+    STATS_ADD(history, nodes_visited, 1);
+
+    // Within num_fleets a segment has no holes
+    if (!visitor){
+      query_scan(query, store->status_flags + battle->store_offset, store->total_ships + battle->store_offset, NULL, battle->num_fleets, result);
+    }
+    else if (query_scan_visit(query, history, battle, result, visitor, ctx) != 0) break;
+  }
+  return 0;
+}
+
+
+// Returns: The count of matching fleets, -1 on error (e.g., NULL history).
+int count_fleets_matching(struct galaxy_history_t *history, const struct fleet_query_t *query){
+  if (!history || !query) return -1;
+
+  // Flags alone: every fleet with an accepted flags value matches
+  if (query->every_date && query->every_ship_count){
+    size_t count = 0;
+    for (int flags = 0; flags < 256; ++flags){
+      if (query->accept[flags]) count += history->store.flag_histogram[flags];
+    }
+    return (int) count;
+  }
+
+  struct fleet_query_result_t result;
+  if (run_fleet_query(history, query, &result, NULL, NULL) != 0) return -1;
+  return (int) result.fleets;
+}
@@ -0,0 +1,376 @@
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include "fleet_store.h"
+#include "string_pool.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Binary snapshot of a galaxy_history_t, all offsets are relative so the file is used
+// straight from the mapping:
+//
+//   snapshot_header_t
+//   string table      every distinct name once, NUL-terminated, padded to 8 bytes
+//   battle records    snapshot_battle_t, oldest battle first
+//   fleet records     snapshot_fleet_t, grouped by battle in battle order
+//
+// Numbers are stored in host byte order, byte_order tells a foreign file apart.
+// The checksum covers the whole file, the header with its checksum field zeroed.
+
+#define SNAPSHOT_MAGIC "GWSNAP\0"
+#define SNAPSHOT_VERSION 3u
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+
+struct snapshot_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t battle_count;
+  uint64_t fleet_count;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+  uint64_t battles_offset;
+  uint64_t fleets_offset;
+  uint64_t checksum;
+  uint64_t unknown_statuses;   // galaxy_history_t::unknown_statuses (since version 2).
+};
+
+
+struct snapshot_battle_t {
+  uint64_t first_fleet;        // Index of the battle's first fleet record.
+  uint32_t name_offset;        // Offset of the name in the string table.
+  uint32_t name_length;
+  uint32_t battle_date;
+  uint32_t num_fleets;
+};
+
+
+struct snapshot_fleet_t {
+  uint32_t name_offset;
+  uint32_t name_length;
+  uint32_t total_ships;
+  uint8_t status_flags;
+  uint8_t reserved[3];
+};
+
+
+// FNV-1a variant eating 8 bytes per step, the tail byte by byte
+uint64_t snapshot_checksum(uint64_t hash, const unsigned char *data, size_t size){
+  size_t i = 0;
+  for ( ; i + 8 <= size; i += 8){
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  for ( ; i < size; ++i) hash = (hash ^ data[i]) * 1099511628211ULL;
+  return hash;
+}
+
+#define SNAPSHOT_CHECKSUM_SEED 14695981039346656037ULL
+
+
+// Starts the checksum with the header, so corrupted counts or unknown_statuses are caught too
+uint64_t snapshot_header_checksum(const struct snapshot_header_t *header){
+  struct snapshot_header_t copy = *header;
+  copy.checksum = 0;
+  return snapshot_checksum(SNAPSHOT_CHECKSUM_SEED, (const unsigned char *) &copy, sizeof(copy));
+}
+
+
+// Helper functions for the string table.........
+
+
+// Distinct strings written so far, open addressing on the string contents
+struct snapshot_strings_t {
+  char *data;
+  size_t size;
+  size_t capacity;
+  uint32_t *slots;             // Offset + 1 of each stored string, 0 is an empty slot.
+  size_t slot_count;
+  size_t used_slots;
+};
+
+
+size_t snapshot_string_hash(const char *str, size_t len){
+  size_t hash = (size_t) 14695981039346656037ULL;
+  for (size_t i = 0; i < len; ++i) hash = (hash ^ (unsigned char) str[i]) * (size_t) 1099511628211ULL;
+  return hash;
+}
+
+
+// Stores `str` once and returns its offset through `offset`
+// Returns 0 on success, 4 on memory allocation error, 3 if the table outgrows 32-bit offsets
+int snapshot_strings_add(struct snapshot_strings_t *strings, const char *str, uint32_t *offset){
+  size_t len = strlen(str);
+
+  if ((strings->used_slots + 1) * 2 > strings->slot_count){
+    size_t slot_count = strings->slot_count ? strings->slot_count * 2 : 1024;
+    uint32_t *slots = (uint32_t *) calloc(slot_count, sizeof(uint32_t));
+    if (!slots) return 4;
+
+    for (size_t i = 0; i < strings->slot_count; ++i){
+      if (!strings->slots[i]) continue;
+      const char *old = strings->data + strings->slots[i] - 1;
+      size_t slot = snapshot_string_hash(old, strlen(old)) & (slot_count - 1);
+      while (slots[slot]) slot = (slot + 1) & (slot_count - 1);
+      slots[slot] = strings->slots[i];
+    }
+    free(strings->slots);
+    strings->slots = slots;
+    strings->slot_count = slot_count;
+  }
+
+  size_t slot = snapshot_string_hash(str, len) & (strings->slot_count - 1);
+  while (strings->slots[slot]){
+    const char *old = strings->data + strings->slots[slot] - 1;
+    if (strcmp(old, str) == 0){
+      *offset = strings->slots[slot] - 1;
+      return 0;
+    }
+    slot = (slot + 1) & (strings->slot_count - 1);
+  }
+
+  if (strings->size + len + 1 >= UINT32_MAX) return 3;
+  if (strings->size + len + 1 > strings->capacity){
+    size_t capacity = strings->capacity ? strings->capacity * 2 : 4096;
+    while (capacity < strings->size + len + 1) capacity *= 2;
+    char *data = (char *) realloc(strings->data, capacity);
+    if (!data) return 4;
+    strings->data = data;
+    strings->capacity = capacity;
+  }
+
+  memcpy(strings->data + strings->size, str, len + 1);
+  *offset = (uint32_t) strings->size;
+  strings->slots[slot] = (uint32_t) strings->size + 1;
+  strings->size += len + 1;
+  strings->used_slots++;
+  return 0;
+}
+
+
+// Saves a binary snapshot of the history.
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening/writing error,
+//          3 - history too big for the format, 4 - memory allocation error.
+int save_galactic_snapshot(const struct galaxy_history_t *history, const char *fname){
+  if (!history || !fname) return 1;
+
+  size_t fleet_count = 0;
+  for (struct battle_node_t *node = history->head; node; node = node->next) fleet_count += node->battle->num_fleets;
+
+  struct snapshot_strings_t strings = {NULL, 0, 0, NULL, 0, 0};
+  struct snapshot_battle_t *battles = (struct snapshot_battle_t *) calloc(history->total_battles ? history->total_battles : 1, sizeof(struct snapshot_battle_t));
+  struct snapshot_fleet_t *fleets = (struct snapshot_fleet_t *) calloc(fleet_count ? fleet_count : 1, sizeof(struct snapshot_fleet_t));
+  int res = (!battles || !fleets) ? 4 : 0;
+
+  // Oldest battle first, so loading with pushfront_node restores the list order
+  size_t battle_count = 0;
+  size_t fleet_index = 0;
+  for (struct battle_node_t *node = history->tail; node && !res; node = node->prev){
+    STATS_ADD(history, nodes_visited, 1);
+    struct battle_t *battle = node->battle;
+    struct snapshot_battle_t *record = &battles[battle_count++];
+
+    record->first_fleet = fleet_index;
+    record->name_length = (uint32_t) strlen(battle->battle_name);
+    record->battle_date = battle->battle_date;
+    record->num_fleets = (uint32_t) battle->num_fleets;
+    res = snapshot_strings_add(&strings, battle->battle_name, &record->name_offset);
+
+    for (size_t i = 0; i < battle->num_fleets && !res; ++i){
+      struct fleet_status_t *fleet = battle->fleet_statuses[i];
+      struct snapshot_fleet_t *out = &fleets[fleet_index++];
+      out->name_length = (uint32_t) strlen(fleet->fleet_name);
+      out->total_ships = fleet->total_ships;
+      out->status_flags = fleet->status_flags;
+      res = snapshot_strings_add(&strings, fleet->fleet_name, &out->name_offset);
+    }
+  }
+
+  // Pad the string table so the records stay 8-byte aligned
+  size_t strings_padded = (strings.size + 7) & ~(size_t) 7;
+  if (!res && strings_padded > strings.capacity){
+    char *data = (char *) realloc(strings.data, strings_padded);
+    if (!data) res = 4;
+    else strings.data = data;
+  }
+  if (!res && strings_padded) memset(strings.data + strings.size, 0, strings_padded - strings.size);
+
+  struct snapshot_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.battle_count = battle_count;
+  header.fleet_count = fleet_index;
+  header.strings_offset = sizeof(header);
+  header.strings_size = strings.size;
+  header.battles_offset = header.strings_offset + strings_padded;
+  header.fleets_offset = header.battles_offset + battle_count * sizeof(struct snapshot_battle_t);
+  header.unknown_statuses = history->unknown_statuses;
+
+  if (!res){
+    // Every section is a multiple of 8 bytes, so summing them one by one equals one pass over the file
+    uint64_t checksum = snapshot_header_checksum(&header);
+    if (strings_padded) checksum = snapshot_checksum(checksum, (const unsigned char *) strings.data, strings_padded);
+    checksum = snapshot_checksum(checksum, (const unsigned char *) battles, battle_count * sizeof(struct snapshot_battle_t));
+    checksum = snapshot_checksum(checksum, (const unsigned char *) fleets, fleet_index * sizeof(struct snapshot_fleet_t));
+    header.checksum = checksum;
+
+    FILE *file = fopen(fname, "wb");
+    if (!file) res = 2;
+    else {
+      if (fwrite(&header, sizeof(header), 1, file) != 1
+          || (strings_padded && fwrite(strings.data, strings_padded, 1, file) != 1)
+          || (battle_count && fwrite(battles, sizeof(struct snapshot_battle_t), battle_count, file) != battle_count)
+          || (fleet_index && fwrite(fleets, sizeof(struct snapshot_fleet_t), fleet_index, file) != fleet_index)) res = 2;
+      if (fclose(file) != 0) res = 2;
+    }
+  }
+
+  free(strings.data);
+  free(strings.slots);
+  free(battles);
+  free(fleets);
+  return res;
+}
+
+
+// Checks that the mapping is a complete, uncorrupted snapshot
+// Returns 0 if valid, 3 otherwise
+int validate_snapshot(const unsigned char *data, size_t size){
+  if (size < sizeof(struct snapshot_header_t)) return 3;
+
+  const struct snapshot_header_t *header = (const struct snapshot_header_t *) data;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) return 3;
+  if (header->version != SNAPSHOT_VERSION || header->byte_order != SNAPSHOT_BYTE_ORDER) return 3;
+
+  // Sections must follow each other exactly up to the end of the file
+  uint64_t strings_padded = (header->strings_size + 7) & ~(uint64_t) 7;
+  if (header->strings_offset != sizeof(*header) || header->strings_size > size) return 3;
+  if (header->battles_offset != header->strings_offset + strings_padded) return 3;
+  if (header->battle_count > size / sizeof(struct snapshot_battle_t) || header->fleet_count > size / sizeof(struct snapshot_fleet_t)) return 3;
+  if (header->fleets_offset != header->battles_offset + header->battle_count * sizeof(struct snapshot_battle_t)) return 3;
+  if (header->fleets_offset + header->fleet_count * sizeof(struct snapshot_fleet_t) != size) return 3;
+
+  uint64_t checksum = snapshot_checksum(snapshot_header_checksum(header), data + sizeof(*header), size - sizeof(*header));
+  if (checksum != header->checksum) return 3;
+
+  // Every name must be a NUL-terminated string inside the table
+  const char *strings = (const char *) data + header->strings_offset;
+  const struct snapshot_battle_t *battles = (const struct snapshot_battle_t *) (data + header->battles_offset);
+  const struct snapshot_fleet_t *fleets = (const struct snapshot_fleet_t *) (data + header->fleets_offset);
+
+  uint64_t next_fleet = 0;
+  for (uint64_t i = 0; i < header->battle_count; ++i){
+    const struct snapshot_battle_t *battle = &battles[i];
+    if ((uint64_t) battle->name_offset + battle->name_length >= header->strings_size) return 3;
+    if (strings[battle->name_offset + battle->name_length] != '\0') return 3;
+    if (battle->first_fleet != next_fleet || battle->num_fleets > header->fleet_count - next_fleet) return 3;
+    next_fleet += battle->num_fleets;
+  }
+  if (next_fleet != header->fleet_count) return 3;
+
+  for (uint64_t i = 0; i < header->fleet_count; ++i){
+    const struct snapshot_fleet_t *fleet = &fleets[i];
+    if ((uint64_t) fleet->name_offset + fleet->name_length >= header->strings_size) return 3;
+    if (strings[fleet->name_offset + fleet->name_length] != '\0') return 3;
+  }
+  return 0;
+}
+
+
+// Builds the history from a validated snapshot, names point into the mapping
+// Returns 0 on success, 4 on memory allocation error
+int build_from_snapshot(struct galaxy_history_t *history, const unsigned char *data){
+  const struct snapshot_header_t *header = (const struct snapshot_header_t *) data;
+  const char *strings = (const char *) data + header->strings_offset;
+  const struct snapshot_battle_t *battles = (const struct snapshot_battle_t *) (data + header->battles_offset);
+  const struct snapshot_fleet_t *records = (const struct snapshot_fleet_t *) (data + header->fleets_offset);
+  history->unknown_statuses = (size_t) header->unknown_statuses;
+
+  // All structs of one kind come from a single arena allocation
+  size_t battle_count = (size_t) header->battle_count;
+  size_t fleet_count = (size_t) header->fleet_count;
+  struct battle_node_t *nodes = (struct battle_node_t *) history_alloc(history, (battle_count ? battle_count : 1) * sizeof(struct battle_node_t));
+  struct battle_t *battle_data = (struct battle_t *) history_alloc(history, (battle_count ? battle_count : 1) * sizeof(struct battle_t));
+  struct fleet_status_t *fleets = (struct fleet_status_t *) history_alloc(history, (fleet_count ? fleet_count : 1) * sizeof(struct fleet_status_t));
+  struct fleet_status_t **pointers = (struct fleet_status_t **) history_alloc(history, (fleet_count + battle_count + 1) * sizeof(struct fleet_status_t *));
+  if (!nodes || !battle_data || !fleets || !pointers) return 4;
+
+  for (size_t i = 0; i < fleet_count; ++i){
+    fleets[i].status_flags = records[i].status_flags;
+    fleets[i].total_ships = records[i].total_ships;
+    fleets[i].fleet_name = (char *) strings + records[i].name_offset;
+  }
+
+  for (size_t i = 0; i < battle_count; ++i){
+    struct battle_t *battle = &battle_data[i];
+    // Battle names are interned in place for the index, fleet names are already stored once
+    battle->name_id = string_pool_intern_external(history->names, strings + battles[i].name_offset, battles[i].name_length);
+    if (battle->name_id == STRING_POOL_NO_ID) return 4;
+    battle->battle_name = (char *) history->names->entries[battle->name_id].str;
+    battle->battle_date = battles[i].battle_date;
+    battle->num_fleets = battles[i].num_fleets;
+    battle->fleet_capacity = battle->num_fleets + 1;
+    battle->store_offset = 0;
+    battle->store_capacity = 0;
+
+    // Each fleet array is a slice of the shared pointer block plus its NULL
+    battle->fleet_statuses = pointers;
+    for (size_t f = 0; f < battle->num_fleets; ++f) pointers[f] = &fleets[battles[i].first_fleet + f];
+    pointers[battle->num_fleets] = NULL;
+    pointers += battle->num_fleets + 1;
+
+    nodes[i].battle = battle;
+    nodes[i].prev = NULL;
+    nodes[i].next = NULL;
+    if (pushfront_node(history, &nodes[i]) != 0) return 4;
+    history->total_battles++;
+
+    if (fleet_store_reserve(&history->store, battle, battle->num_fleets) != 0) return 4;
+    for (size_t f = 0; f < battle->num_fleets; ++f){
+      fleet_store_set(&history->store, battle, f, battle->fleet_statuses[f]->status_flags, battle->fleet_statuses[f]->total_ships);
+    }
+  }
+  return 0;
+}
+
+
+// Loads a snapshot written by save_galactic_snapshot.
+// Returns: 0 - success, 1 - invalid input, 2 - file opening error,
+//          3 - corrupted or foreign snapshot, 4 - memory allocation error.
+int load_galactic_snapshot(const char *fname, struct galaxy_history_t **history_ptr){
+  if (!fname || !history_ptr) return 1;
+  if (*history_ptr && (!(*history_ptr)->arena || (*history_ptr)->head || (*history_ptr)->snapshot_map)) return 1;
+
+  const char *data;
+  size_t size;
+  if (map_galactic_file(fname, &data, &size) != 0) return 2;
+
+  int res = validate_snapshot((const unsigned char *) data, size);
+  if (!res && !*history_ptr) res = initialize_history_with_arena(history_ptr, 0);
+  if (res){
+    unmap_galactic_file(data, size);
+    destroy_galactic_history(history_ptr);
+    return res;
+  }
+
+  // The history keeps the mapping alive, names live in it
+  (*history_ptr)->snapshot_map = data;
+  (*history_ptr)->snapshot_size = size;
+
+  res = build_from_snapshot(*history_ptr, (const unsigned char *) data);
+  if (res) destroy_galactic_history(history_ptr);
+  return res;
+}
+
+
+void release_snapshot_mapping(struct galaxy_history_t *history){
+  unmap_galactic_file((const char *) history->snapshot_map, history->snapshot_size);
+  history->snapshot_map = NULL;
+  history->snapshot_size = 0;
+}
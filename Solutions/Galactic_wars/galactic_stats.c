@@ -0,0 +1,83 @@
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include "string_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Instrumentation counters of a history, compiled in with -DGALACTIC_STATS. The hot paths
+// bump them through the STATS_* macros of galactic_internal.h and the fleet store through its
+// stats pointer; the name pool keeps its own compare counter, folded in when the stats are read.
+
+const char *const history_phase_names[HISTORY_PHASES] = {"read", "parse", "build", "merge"};
+
+
+#ifdef GALACTIC_STATS
+double stats_now_ms(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e3 + (double) ts.tv_nsec / 1e6;
+}
+
+
+// Charges the time since the last switch to the running phase and starts `phase`
+void stats_enter_phase(struct history_stats_t *stats, struct stats_clock_t *clock, int phase){
+  double now = stats_now_ms();
+  if (clock->phase >= 0 && clock->phase < HISTORY_PHASES) stats->phase_ms[clock->phase] += now - clock->start;
+  clock->start = now;
+  clock->phase = phase;
+}
+
+
+// Adds everything counted while loading `partial` to `history` (parallel loader)
+void stats_accumulate(struct galaxy_history_t *history, const struct galaxy_history_t *partial){
+  struct history_stats_t counted;
+  get_history_stats(partial, &counted);
+
+  history->stats->nodes_visited += counted.nodes_visited;
+  history->stats->index_probes += counted.index_probes;
+  history->stats->name_compares += counted.name_compares;
+  history->stats->reallocs += counted.reallocs;
+  history->stats->bytes_allocated += counted.bytes_allocated;
+  for (int i = 0; i < HISTORY_PHASES; ++i) history->stats->phase_ms[i] += counted.phase_ms[i];
+}
+#endif
+
+
+// Returns: 0 - success, 1 - invalid input (NULL), 5 - built without GALACTIC_STATS.
+int get_history_stats(const struct galaxy_history_t *history, struct history_stats_t *stats){
+  if (!history || !stats) return 1;
+
+  memset(stats, 0, sizeof(*stats));
+  // Decided by how the library was built, not by the caller's flags
+  if (!history->stats) return 5;
+
+  *stats = *history->stats;
+  stats->name_compares += history->names->compares;
+  return 0;
+}
+
+
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening/writing error,
+//          5 - built without GALACTIC_STATS.
+int save_history_stats_json(const struct galaxy_history_t *history, const char *fname){
+  if (!history || !fname) return 1;
+
+  struct history_stats_t stats;
+  int res = get_history_stats(history, &stats);
+  if (res) return res;
+
+  FILE *file = fopen(fname, "w");
+  if (!file) return 2;
+
+  fprintf(file, "{\"nodes_visited\": %zu, \"index_probes\": %zu, \"name_compares\": %zu, \"reallocs\": %zu, \"bytes_allocated\": %zu, \"phase_ms\": {",
+          stats.nodes_visited, stats.index_probes, stats.name_compares, stats.reallocs, stats.bytes_allocated);
+  for (int i = 0; i < HISTORY_PHASES; ++i){
+    fprintf(file, "%s\"%s\": %.3f", i ? ", " : "", history_phase_names[i], stats.phase_ms[i]);
+  }
+  fprintf(file, "}, \"unknown_statuses\": %zu}\n", history->unknown_statuses);
+
+  if (ferror(file)) res = 2;
+  if (fclose(file) != 0) res = 2;
+  return res;
+}
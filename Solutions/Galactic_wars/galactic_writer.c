@@ -0,0 +1,123 @@
+#include "galactic_func.h"
+#include "galactic_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Buffered text output without stdio formatting: numbers and flags are formatted by hand
+// into a large buffer that goes out in a single fwrite when it fills up.
+
+#define WRITER_BUFFER_SIZE (1 << 20)
+
+// Status names in bit order, as set_fleet_status_n decodes them
+const char *const status_bit_names[4] = {"Ready for Jump", "Shield Active", "Critical Damage", "Withdrawal"};
+
+
+void writer_open(struct history_writer_t *writer, FILE *file){
+  writer->file = file;
+  writer->len = 0;
+  writer->error = 0;
+  writer->buffer = (char *) malloc(WRITER_BUFFER_SIZE);
+  writer->capacity = WRITER_BUFFER_SIZE;
+  if (!writer->buffer){
+    // Slower, but the output is still complete
+    writer->buffer = writer->fallback;
+    writer->capacity = sizeof(writer->fallback);
+  }
+}
+
+
+void writer_flush(struct history_writer_t *writer){
+  if (writer->len && fwrite(writer->buffer, 1, writer->len, writer->file) != writer->len) writer->error = 1;
+  writer->len = 0;
+}
+
+
+// Flushes the rest and frees the buffer, returns 0 on success, 2 on writing error
+int writer_close(struct history_writer_t *writer){
+  writer_flush(writer);
+  if (writer->buffer != writer->fallback) free(writer->buffer);
+  writer->buffer = NULL;
+  return writer->error ? 2 : 0;
+}
+
+
+void writer_put(struct history_writer_t *writer, const char *data, size_t len){
+  if (writer->capacity - writer->len < len){
+    writer_flush(writer);
+    // Pieces bigger than the buffer skip it
+    if (len > writer->capacity){
+      if (fwrite(data, 1, len, writer->file) != len) writer->error = 1;
+      return;
+    }
+  }
+  memcpy(writer->buffer + writer->len, data, len);
+  writer->len += len;
+}
+
+
+void writer_puts(struct history_writer_t *writer, const char *str){
+  writer_put(writer, str, strlen(str));
+}
+
+
+void writer_putc(struct history_writer_t *writer, char c){
+  if (writer->len == writer->capacity) writer_flush(writer);
+  writer->buffer[writer->len++] = c;
+}
+
+
+// Writes the decimal digits of `value`
+void writer_put_number(struct history_writer_t *writer, unsigned long long value){
+  char digits[20];
+  size_t count = 0;
+  do {
+    digits[sizeof(digits) - ++count] = (char) ('0' + value % 10);
+    value /= 10;
+  } while (value);
+  writer_put(writer, digits + sizeof(digits) - count, count);
+}
+
+
+// Saves the history in the BATTLE:/DATE:/FLEET: text format read by load_galactic_history.
+// Returns: 0 - success, 1 - invalid input (NULL), 2 - file opening/writing error.
+int save_galactic_history(const struct galaxy_history_t *history, const char *fname){
+  if (!history || !fname) return 1;
+
+  FILE *file = fopen(fname, "w");
+  if (!file) return 2;
+
+  struct history_writer_t writer;
+  writer_open(&writer, file);
+
+  // Oldest battle first, loading pushes to the front and restores this order
+  for (struct battle_node_t *node = history->tail; node; node = node->prev){
+    STATS_ADD(history, nodes_visited, 1);
+    struct battle_t *battle = node->battle;
+    if (!battle) continue;
+
+    writer_put(&writer, "BATTLE:", 7);
+    writer_puts(&writer, battle->battle_name);
+    writer_put(&writer, "\nDATE:", 6);
+    writer_put_number(&writer, battle->battle_date);
+    writer_putc(&writer, '\n');
+
+    for (size_t i = 0; i < battle->num_fleets; ++i){
+      struct fleet_status_t *fleet = battle->fleet_statuses[i];
+      writer_put(&writer, "FLEET:", 6);
+      writer_puts(&writer, fleet->fleet_name);
+      writer_put(&writer, "|0|", 3);
+      writer_put_number(&writer, fleet->total_ships);
+      for (int bit = 0; bit < 4; ++bit){
+        if (!(fleet->status_flags & (1u << bit))) continue;
+        writer_putc(&writer, '|');
+        writer_puts(&writer, status_bit_names[bit]);
+      }
+      writer_putc(&writer, '\n');
+    }
+  }
+
+  int res = writer_close(&writer);
+  if (fclose(file) != 0) res = 2;
+  return res;
+}
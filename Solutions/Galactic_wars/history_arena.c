@@ -0,0 +1,105 @@
+#include "history_arena.h"
+#include <stdlib.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+
+int arena_init(struct history_arena_t *arena, size_t block_size){
+  if (!arena) return 1;
+
+  arena->blocks = NULL;
+  arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+  arena->adopted = NULL;
+  arena->adopted_count = 0;
+  arena->adopted_capacity = 0;
+  arena->bytes_allocated = 0;
+  return 0;
+}
+
+
+// Allocates a new block able to hold at least `size` bytes and makes it current
+struct arena_block_t *arena_new_block(struct history_arena_t *arena, size_t size){
+  int dedicated = size > arena->block_size / 4;
+  size_t usable = dedicated ? size : arena->block_size;
+
+  struct arena_block_t *block = (struct arena_block_t *) malloc(sizeof(struct arena_block_t) + usable);
+  if (!block) return NULL;
+
+  block->size = usable;
+  block->used = 0;
+
+  // Oversized requests get a dedicated block behind the current one, so its free space is not lost
+  if (dedicated && arena->blocks){
+    block->next = arena->blocks->next;
+    arena->blocks->next = block;
+  } else {
+    block->next = arena->blocks;
+    arena->blocks = block;
+  }
+  return block;
+}
+
+
+void *arena_alloc(struct history_arena_t *arena, size_t size){
+  if (!arena) return NULL;
+  if (!size) size = 1;
+
+  // Round the size up so every allocation starts aligned (block data is aligned by malloc)
+  size_t rounded = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+  if (rounded < size) return NULL; // Overflow
+
+  struct arena_block_t *block = arena->blocks;
+  if (!block || block->size - block->used < rounded){
+    block = arena_new_block(arena, rounded);
+    if (!block) return NULL;
+  }
+
+  void *ptr = block->data + block->used;
+  block->used += rounded;
+  arena->bytes_allocated += size;
+  return ptr;
+}
+
+
+int arena_reserve_adopted(struct history_arena_t *arena, size_t count){
+  if (!arena) return 1;
+  if (arena->adopted_capacity - arena->adopted_count >= count) return 0;
+
+  size_t capacity = arena->adopted_capacity ? arena->adopted_capacity * 2 : 16;
+  while (capacity - arena->adopted_count < count) capacity *= 2;
+
+  void **resized = (void **) realloc(arena->adopted, capacity * sizeof(void *));
+  if (!resized) return 4;
+
+  arena->adopted = resized;
+  arena->adopted_capacity = capacity;
+  return 0;
+}
+
+
+int arena_adopt(struct history_arena_t *arena, void *ptr){
+  if (!arena) return 1;
+  if (!ptr) return 0;
+  if (arena_reserve_adopted(arena, 1) != 0) return 4;
+
+  arena->adopted[arena->adopted_count++] = ptr;
+  return 0;
+}
+
+
+void arena_release(struct history_arena_t *arena){
+  if (!arena) return;
+
+  struct arena_block_t *block = arena->blocks;
+  while (block){
+    struct arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  for (size_t i = 0; i < arena->adopted_count; ++i) free(arena->adopted[i]);
+  free(arena->adopted);
+
+  arena_init(arena, arena->block_size);
+}
@@ -0,0 +1,45 @@
+#ifndef HISTORY_ARENA_H
+#define HISTORY_ARENA_H
+#include <stddef.h>
+
+// Bump allocator owning the nodes, battles and fleets of one galaxy_history_t (names belong
+// to the history's string pool). Nothing allocated from it is freed one by one, the whole arena is released at once.
+
+// One chunk of arena memory, blocks are chained newest first.
+struct arena_block_t {
+  struct arena_block_t *next;      // Previously filled block.
+  size_t size;                     // Usable bytes in data.
+  size_t used;                     // Bytes already handed out.
+  unsigned char data[];            // Storage handed out by arena_alloc.
+};
+
+
+struct history_arena_t {
+  struct arena_block_t *blocks;    // Current block (head of the chain).
+  size_t block_size;               // Size of regular blocks, bigger requests get their own block.
+  void **adopted;                  // Heap pointers handed over to the history, freed on release.
+  size_t adopted_count;            // Number of pointers in adopted.
+  size_t adopted_capacity;         // Slots allocated in adopted.
+  size_t bytes_allocated;          // Bytes handed out by arena_alloc (without alignment padding).
+};
+
+
+// Prepares an empty arena, `block_size` 0 picks the default (64 KiB).
+// Returns 0 on success, 1 on invalid input.
+int arena_init(struct history_arena_t *arena, size_t block_size);
+
+// Returns `size` bytes aligned for any type, or NULL on memory allocation error.
+void *arena_alloc(struct history_arena_t *arena, size_t size);
+
+// Makes sure the next `count` arena_adopt calls cannot fail.
+// Returns 0 on success, 4 on memory allocation error.
+int arena_reserve_adopted(struct history_arena_t *arena, size_t count);
+
+// Takes ownership of a malloc'd pointer so it is freed together with the arena.
+// Returns 0 on success, 4 on memory allocation error.
+int arena_adopt(struct history_arena_t *arena, void *ptr);
+
+// Frees every block and adopted pointer, the arena is empty afterwards.
+void arena_release(struct history_arena_t *arena);
+
+#endif //HISTORY_ARENA_H
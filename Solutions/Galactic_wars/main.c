@@ -3,8 +3,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-int main(void){
-  char *file = "../galactic_data.txt";
+int main(int argc, char **argv){
+  // Optional history file, e.g. one written by bench_galactic --data
+  const char *file = argc > 1 ? argv[1] : "../galactic_data.txt";
 
   // Main struct declaration
   struct galaxy_history_t *data = NULL;
@@ -38,9 +39,15 @@ int main(void){
   new_fleet->total_ships = 134;
   new_fleet->status_flags = 5;
   int added = add_fleet_to_battle(data, "Battle of Yavin", 19770525, new_fleet);
-  if (added != 0) printf("ERROR WHILE ADDING FLEER\n");
+  if (added != 0){
+    // Not adopted, e.g. the file has no such battle
+    printf("ERROR WHILE ADDING FLEER\n");
+    free(new_fleet->fleet_name);
+    free(new_fleet);
+  }
 
   display_galactic_history(data);
+  printf("\nUnrecognized fleet status fields -> %zu\n", data->unknown_statuses);
 
   printf("\nChanging fleet statuses\n");
   int first_bit_set = count_fleets_with_status_bits(data, (1u << 0));
@@ -0,0 +1,194 @@
+#include "string_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_BLOCK_SIZE (64 * 1024)
+#define POOL_ID_SIZE sizeof(unsigned int)
+
+
+size_t string_pool_hash(const char *str, size_t len){
+  size_t hash = (size_t) 14695981039346656037ULL;
+  for (size_t i = 0; i < len; ++i){
+    hash ^= (unsigned char) str[i];
+    hash *= (size_t) 1099511628211ULL;
+  }
+  return hash;
+}
+
+
+void string_pool_init(struct string_pool_t *pool){
+  pool->entries = NULL;
+  pool->count = 0;
+  pool->capacity = 0;
+  pool->slots = NULL;
+  pool->slot_capacity = 0;
+  pool->blocks = NULL;
+  pool->interned = 0;
+  pool->bytes_requested = 0;
+  pool->bytes_stored = 0;
+  pool->compares = 0;
+}
+
+
+void string_pool_free(struct string_pool_t *pool){
+  struct pool_block_t *block = pool->blocks;
+  while (block){
+    struct pool_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(pool->entries);
+  free(pool->slots);
+  string_pool_init(pool);
+}
+
+
+unsigned int string_pool_find(const struct string_pool_t *pool, const char *str, size_t len, size_t hash){
+  if (!pool->slot_capacity) return STRING_POOL_NO_ID;
+
+  size_t mask = pool->slot_capacity - 1;
+  for (size_t slot = hash & mask; pool->slots[slot]; slot = (slot + 1) & mask){
+    const struct pool_entry_t *entry = &pool->entries[pool->slots[slot] - 1];
+#ifdef GALACTIC_STATS
+    // Counter only, a lookup does not change the pool otherwise
+    __atomic_fetch_add(&((struct string_pool_t *) pool)->compares, 1, __ATOMIC_RELAXED);
+#endif
+    if (entry->hash == hash && entry->len == len && memcmp(entry->str, str, len) == 0) return pool->slots[slot] - 1;
+  }
+  return STRING_POOL_NO_ID;
+}
+
+
+unsigned int string_pool_id_of(const char *pooled){
+  unsigned int id;
+  memcpy(&id, pooled - POOL_ID_SIZE, POOL_ID_SIZE);
+  return id;
+}
+
+
+// Makes room for one more entry, keeping the slot table under 1/2 full
+// Returns 0 on success, 4 on memory allocation error
+int string_pool_grow(struct string_pool_t *pool){
+  if (pool->count == STRING_POOL_NO_ID - 1) return 4;
+
+  if (pool->count == pool->capacity){
+    size_t capacity = pool->capacity ? pool->capacity * 2 : 64;
+    struct pool_entry_t *entries = (struct pool_entry_t *) realloc(pool->entries, capacity * sizeof(struct pool_entry_t));
+    if (!entries) return 4;
+    pool->entries = entries;
+    pool->capacity = capacity;
+  }
+
+  if ((pool->count + 1) * 2 > pool->slot_capacity){
+    size_t capacity = pool->slot_capacity ? pool->slot_capacity * 2 : 128;
+    unsigned int *slots = (unsigned int *) calloc(capacity, sizeof(unsigned int));
+    if (!slots) return 4;
+
+    // Rehash from the stored hashes, no name is read again
+    for (size_t id = 0; id < pool->count; ++id){
+      size_t slot = pool->entries[id].hash & (capacity - 1);
+      while (slots[slot]) slot = (slot + 1) & (capacity - 1);
+      slots[slot] = (unsigned int) id + 1;
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_capacity = capacity;
+  }
+  return 0;
+}
+
+
+// Copies the name behind its id into the current block
+// Returns the copy, NULL on memory allocation error
+char *string_pool_store(struct string_pool_t *pool, const char *str, size_t len, unsigned int id){
+  size_t size = POOL_ID_SIZE + len + 1;
+
+  struct pool_block_t *block = pool->blocks;
+  if (!block || block->size - block->used < size){
+    // Long names get a block of their own behind the current one
+    int dedicated = size > POOL_BLOCK_SIZE / 4;
+    size_t usable = dedicated ? size : POOL_BLOCK_SIZE;
+    block = (struct pool_block_t *) malloc(sizeof(struct pool_block_t) + usable);
+    if (!block) return NULL;
+
+    block->size = usable;
+    block->used = 0;
+    if (dedicated && pool->blocks){
+      block->next = pool->blocks->next;
+      pool->blocks->next = block;
+    } else {
+      block->next = pool->blocks;
+      pool->blocks = block;
+    }
+  }
+
+  char *copy = block->data + block->used + POOL_ID_SIZE;
+  memcpy(copy - POOL_ID_SIZE, &id, POOL_ID_SIZE);
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  block->used += size;
+  pool->bytes_stored += size;
+  return copy;
+}
+
+
+// Adds a new entry, copying the name unless it is external
+unsigned int string_pool_insert(struct string_pool_t *pool, const char *str, size_t len, size_t hash, int external){
+  if (string_pool_grow(pool) != 0) return STRING_POOL_NO_ID;
+
+  unsigned int id = (unsigned int) pool->count;
+  const char *stored = external ? str : string_pool_store(pool, str, len, id);
+  if (!stored) return STRING_POOL_NO_ID;
+
+  pool->entries[id].str = stored;
+  pool->entries[id].len = len;
+  pool->entries[id].hash = hash;
+  pool->count++;
+
+  size_t mask = pool->slot_capacity - 1;
+  size_t slot = hash & mask;
+  while (pool->slots[slot]) slot = (slot + 1) & mask;
+  pool->slots[slot] = id + 1;
+  return id;
+}
+
+
+unsigned int string_pool_intern_hashed(struct string_pool_t *pool, const char *str, size_t len, size_t hash){
+  unsigned int id = string_pool_find(pool, str, len, hash);
+  if (id == STRING_POOL_NO_ID) id = string_pool_insert(pool, str, len, hash, 0);
+  if (id == STRING_POOL_NO_ID) return id;
+
+  pool->interned++;
+  pool->bytes_requested += len + 1;
+  return id;
+}
+
+
+unsigned int string_pool_intern(struct string_pool_t *pool, const char *str, size_t len){
+  return string_pool_intern_hashed(pool, str, len, string_pool_hash(str, len));
+}
+
+
+unsigned int string_pool_intern_external(struct string_pool_t *pool, const char *str, size_t len){
+  size_t hash = string_pool_hash(str, len);
+  unsigned int id = string_pool_find(pool, str, len, hash);
+  if (id == STRING_POOL_NO_ID) id = string_pool_insert(pool, str, len, hash, 1);
+  if (id == STRING_POOL_NO_ID) return id;
+
+  pool->interned++;
+  return id;
+}
+
+
+int string_pool_merge(struct string_pool_t *dst, const struct string_pool_t *src, unsigned int *forward){
+  for (size_t id = 0; id < src->count; ++id){
+    const struct pool_entry_t *entry = &src->entries[id];
+    forward[id] = string_pool_find(dst, entry->str, entry->len, entry->hash);
+    if (forward[id] == STRING_POOL_NO_ID) forward[id] = string_pool_insert(dst, entry->str, entry->len, entry->hash, 0);
+    if (forward[id] == STRING_POOL_NO_ID) return 4;
+  }
+
+  dst->interned += src->interned;
+  dst->bytes_requested += src->bytes_requested;
+  return 0;
+}
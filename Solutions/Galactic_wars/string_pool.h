@@ -0,0 +1,74 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+#include <stddef.h>
+
+// Interned names of one galaxy_history_t. Every distinct name is stored once and gets a
+// dense id, so equal names share storage and compare by id or pointer. Pooled copies are
+// stored as a 4 byte id followed by the NUL-terminated text and never move; external
+// names (e.g. in a mapped snapshot) are referenced in place.
+
+#define STRING_POOL_NO_ID 0xFFFFFFFFu
+
+// One distinct name, entries are indexed by id.
+struct pool_entry_t {
+  const char *str;                 // NUL-terminated text.
+  size_t len;                      // strlen(str).
+  size_t hash;                     // string_pool_hash(str, len).
+};
+
+
+// Storage for pooled copies, blocks are chained newest first.
+struct pool_block_t {
+  struct pool_block_t *next;
+  size_t size;                     // Usable bytes in data.
+  size_t used;                     // Bytes already filled.
+  char data[];
+};
+
+
+struct string_pool_t {
+  struct pool_entry_t *entries;    // Distinct names by id.
+  size_t count;                    // Entries in use.
+  size_t capacity;                 // Entries allocated.
+  unsigned int *slots;             // Open-addressing table of id + 1, 0 means empty.
+  size_t slot_capacity;            // Slots allocated (a power of two, or 0 before first insert).
+  struct pool_block_t *blocks;     // Current block (head of the chain).
+  size_t interned;                 // string_pool_intern calls that returned a name.
+  size_t bytes_requested;          // Bytes separate copies of those names would take (text + NUL).
+  size_t bytes_stored;             // Bytes of pooled copies (id + text + NUL).
+  size_t compares;                 // Entries compared by lookups, only counted with -DGALACTIC_STATS (see get_history_stats).
+};
+
+
+// FNV-1a over str[0, len).
+size_t string_pool_hash(const char *str, size_t len);
+
+// Prepares an empty pool.
+void string_pool_init(struct string_pool_t *pool);
+
+// Frees every pooled copy and table, the pool is empty afterwards.
+void string_pool_free(struct string_pool_t *pool);
+
+// Returns the id of str[0, len), copying it into the pool the first time.
+// `hash`: string_pool_hash(str, len), passed in when the caller already has it.
+// Returns STRING_POOL_NO_ID on memory allocation error.
+unsigned int string_pool_intern(struct string_pool_t *pool, const char *str, size_t len);
+unsigned int string_pool_intern_hashed(struct string_pool_t *pool, const char *str, size_t len, size_t hash);
+
+// Same as string_pool_intern, but a new name is referenced in place: str[len] must be NUL
+// and the text must outlive the pool.
+unsigned int string_pool_intern_external(struct string_pool_t *pool, const char *str, size_t len);
+
+// Interns every name of `src` into `dst`, forward[src id] receives the dst id. The counters
+// of src are added to dst, as if its names had been interned there in the first place.
+// Returns 0 on success, 4 on memory allocation error.
+int string_pool_merge(struct string_pool_t *dst, const struct string_pool_t *src, unsigned int *forward);
+
+// Returns the id of str[0, len), or STRING_POOL_NO_ID if it was never interned.
+unsigned int string_pool_find(const struct string_pool_t *pool, const char *str, size_t len, size_t hash);
+
+// Id of a pooled copy (a pointer returned through entries[id].str for a non-external name).
+// External names and fleet names of snapshot histories have no id in front of them.
+unsigned int string_pool_id_of(const char *pooled);
+
+#endif //STRING_POOL_H
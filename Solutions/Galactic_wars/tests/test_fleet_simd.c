@@ -0,0 +1,114 @@
+// Differential tests of the fleet_simd.h kernels against the scalar loops.
+// Build and run from this directory:
+//   gcc -std=gnu11 -O2 -I.. -o test_fleet_simd test_fleet_simd.c ../fleet_simd.c
+//   ./test_fleet_simd
+// Every kernel the CPU supports runs on random flags for every length 0..MAX_LENGTH (so every
+// vector loop and tail path runs) from every start offset 0..MAX_OFFSET, with all 256 masks
+// and all 3 operations. Bytes around the range must stay untouched. Exits with 1 on any mismatch.
+
+#include "fleet_simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LENGTH 200
+#define MAX_OFFSET 31
+#define GUARD 16
+#define BUFFER_SIZE (GUARD + MAX_OFFSET + MAX_LENGTH + GUARD)
+
+struct kernel_t {
+  const char *name;
+  int level;                   // fleet_simd_detect() level the kernel needs.
+  size_t (*count_any)(const unsigned char *flags, size_t count, unsigned char mask);
+  void (*apply)(unsigned char *flags, size_t count, int operation_type, unsigned char mask);
+};
+
+
+void apply_dispatch(unsigned char *flags, size_t count, int operation_type, unsigned char mask){
+  fleet_flags_apply(flags, count, operation_type, mask);
+}
+
+
+static const struct kernel_t kernels[] = {
+  {"dispatch", 0, fleet_flags_count_any, apply_dispatch},
+#ifdef FLEET_SIMD_X86
+  {"sse2", 1, fleet_flags_count_any_sse2, fleet_flags_apply_sse2},
+  {"avx2", 2, fleet_flags_count_any_avx2, fleet_flags_apply_avx2},
+#endif
+};
+
+
+// Fills flags with random bytes, every fourth buffer with only a few of the low bits
+// set, as real status flags are
+void fill_flags(unsigned char *flags, size_t count, unsigned int round){
+  for (size_t i = 0; i < count; ++i){
+    unsigned char value = (unsigned char) (rand() >> 7);
+    flags[i] = round % 4 == 3 ? value & 0x0F : value;
+  }
+}
+
+
+// Returns the number of mismatches of `kernel` against the scalar loops
+size_t test_kernel(const struct kernel_t *kernel){
+  unsigned char source[BUFFER_SIZE], expected[BUFFER_SIZE], actual[BUFFER_SIZE];
+  size_t mismatches = 0;
+  unsigned int round = 0;
+
+  for (size_t length = 0; length <= MAX_LENGTH; ++length){
+    for (size_t offset = 0; offset <= MAX_OFFSET; ++offset, ++round){
+      fill_flags(source, BUFFER_SIZE, round);
+      const unsigned char *flags = source + GUARD + offset;
+
+      for (unsigned int mask = 0; mask < 256; ++mask){
+        size_t want = fleet_flags_count_any_scalar(flags, length, (unsigned char) mask);
+        size_t got = kernel->count_any(flags, length, (unsigned char) mask);
+        if (got != want && mismatches++ < 10){
+          printf("  %s count_any length %zu offset %zu mask 0x%02x: %zu, scalar %zu\n", kernel->name, length, offset, mask, got, want);
+        }
+
+        for (int operation_type = 0; operation_type < 3; ++operation_type){
+          memcpy(expected, source, BUFFER_SIZE);
+          memcpy(actual, source, BUFFER_SIZE);
+          fleet_flags_apply_scalar(expected + GUARD + offset, length, operation_type, (unsigned char) mask);
+          kernel->apply(actual + GUARD + offset, length, operation_type, (unsigned char) mask);
+          if (memcmp(expected, actual, BUFFER_SIZE) != 0 && mismatches++ < 10){
+            printf("  %s apply op %d length %zu offset %zu mask 0x%02x differs\n", kernel->name, operation_type, length, offset, mask);
+          }
+        }
+      }
+    }
+  }
+  return mismatches;
+}
+
+
+int main(void){
+  int level = 0;
+#ifdef FLEET_SIMD_X86
+  level = fleet_simd_detect();
+#endif
+  srand(1);
+
+  size_t failures = 0;
+  for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k){
+    if (kernels[k].level > level){
+      printf("%s: skipped, not supported by this CPU\n", kernels[k].name);
+      continue;
+    }
+    size_t mismatches = test_kernel(&kernels[k]);
+    printf("%s: %s\n", kernels[k].name, mismatches ? "FAILED" : "ok");
+    failures += mismatches;
+  }
+
+  // Unknown operation types are rejected without touching the flags
+  unsigned char flags[40], copy[40];
+  fill_flags(flags, sizeof(flags), 0);
+  memcpy(copy, flags, sizeof(flags));
+  if (fleet_flags_apply(flags, sizeof(flags), 3, 0xFF) != 1 || fleet_flags_apply(flags, sizeof(flags), -1, 0xFF) != 1 || memcmp(flags, copy, sizeof(flags)) != 0){
+    printf("dispatch: unknown operation type not rejected\n");
+    failures++;
+  }
+
+  printf(failures ? "%zu mismatch(es)\n" : "all kernels match the scalar loops\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+// Regression tests of the history loaders on small input files in this directory.
+// Build and run from this directory:
+//   gcc -std=gnu11 -O2 -pthread -I.. -o test_loaders test_loaders.c $(ls ../*.c | grep -v -e '/main.c$' -e '/bench')
+//   ./test_loaders
+// Exits with 1 when any check fails.
+
+#include "galactic_func.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Byte offset of unknown_statuses in the snapshot header (low byte on little-endian hosts)
+#define SNAPSHOT_UNKNOWN_STATUSES_OFFSET 72
+
+#define CHECK(cond) do { if (!(cond)){ printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static int failures = 0;
+
+
+// Loads `fname` with the loader picked by `kind` (0 - fgets, 1 - mmap, 2 - parallel)
+int load_with(int kind, const char *fname, struct galaxy_history_t **history){
+  if (kind == 0) return load_galactic_history(fname, history);
+  if (kind == 1) return load_galactic_history_mmap(fname, history);
+  return load_galactic_history_parallel(fname, history, 2);
+}
+
+
+// BATTLE:Endor dated 5 gets fleet A; the second BATTLE:Endor gets fleet B before its DATE:5.
+// Both records have the key (Endor, 5), so they must end up as one battle with both fleets.
+void test_late_date_merge(int kind){
+  struct galaxy_history_t *history = NULL;
+  CHECK(initialize_history(&history) == 0);
+  int res = load_with(kind, "late_date_merge.txt", &history);
+  CHECK(res == 0);
+  if (res != 0){
+    destroy_galactic_history(&history);
+    return;
+  }
+
+  struct battle_node_t *node = find_battle_node(history, "Endor", 5);
+  CHECK(history->total_battles == 1);
+  CHECK(node != NULL);
+  CHECK(find_battle_node(history, "Endor", 0) == NULL);
+  if (node){
+    CHECK(node->battle->num_fleets == 2);
+    CHECK(node->battle->fleet_statuses[2] == NULL);
+  }
+  CHECK(history->head == node && history->tail == node);
+  CHECK(count_fleets_with_status_bits(history, 0x03) == 2);
+  CHECK(count_fleets_with_status_bits_in_date_range(history, 0x03, 5, 5) == 2);
+
+  struct name_pool_stats_t names;
+  CHECK(get_name_pool_stats(history, &names) == 0);
+  CHECK(names.names_interned == 3);
+
+  destroy_galactic_history(&history);
+}
+
+
+// Fleet names of a snapshot history point into the mapping, not into the name pool.
+// Loading more data on top of it, with the parallel loader too, must keep every name intact.
+void test_snapshot_then_load(void){
+  char path[] = "/tmp/test_loadersXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  if (fd < 0) return;
+  close(fd);
+
+  struct galaxy_history_t *history = NULL;
+  CHECK(initialize_history(&history) == 0);
+  CHECK(load_galactic_history("late_date_merge.txt", &history) == 0);
+  CHECK(save_galactic_snapshot(history, path) == 0);
+  destroy_galactic_history(&history);
+
+  int res = load_galactic_snapshot(path, &history);
+  CHECK(res == 0);
+  if (!res){
+    CHECK(history->snapshot_map != NULL);
+    CHECK(load_galactic_history_parallel("late_date_merge.txt", &history, 4) == 0);
+
+    struct battle_node_t *node = find_battle_node(history, "Endor", 5);
+    CHECK(history->total_battles == 1);
+    CHECK(node && node->battle->num_fleets == 4);
+    for (size_t i = 0; node && i < node->battle->num_fleets; ++i){
+      CHECK(strcmp(node->battle->fleet_statuses[i]->fleet_name, i % 2 ? "B" : "A") == 0);
+    }
+  }
+  destroy_galactic_history(&history);
+  unlink(path);
+}
+
+
+// Status fields naming no status are counted, and the count survives a snapshot
+void test_unknown_statuses(int kind){
+  char path[] = "/tmp/test_loadersXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  if (fd < 0) return;
+  close(fd);
+
+  struct galaxy_history_t *history = NULL;
+  CHECK(initialize_history(&history) == 0);
+  CHECK(load_with(kind, "unknown_statuses.txt", &history) == 0);
+  CHECK(history->unknown_statuses == 3);
+  CHECK(count_fleets_with_status_bits(history, 0x01) == 2);
+  CHECK(save_galactic_snapshot(history, path) == 0);
+  destroy_galactic_history(&history);
+
+  CHECK(load_galactic_snapshot(path, &history) == 0);
+  CHECK(history && history->unknown_statuses == 3);
+  destroy_galactic_history(&history);
+
+  // The count lives in the header, the checksum must still catch a change to it
+  FILE *file = fopen(path, "r+b");
+  CHECK(file != NULL);
+  if (file){
+    CHECK(fseek(file, SNAPSHOT_UNKNOWN_STATUSES_OFFSET, SEEK_SET) == 0);
+    CHECK(fputc(4, file) == 4);
+    fclose(file);
+    CHECK(load_galactic_snapshot(path, &history) == 3);
+    destroy_galactic_history(&history);
+  }
+  unlink(path);
+}
+
+
+// Allocates a fleet the way callers of add_fleets_to_battle do
+struct fleet_status_t *make_fleet(const char *name){
+  struct fleet_status_t *fleet = (struct fleet_status_t *) calloc(1, sizeof(struct fleet_status_t));
+  fleet->fleet_name = strdup(name);
+  fleet->status_flags = 0x01;
+  return fleet;
+}
+
+
+// A fleet listed twice is rejected before anything is interned or adopted
+void test_bulk_add_repeated_fleet(void){
+  struct galaxy_history_t *history = NULL;
+  CHECK(initialize_history(&history) == 0);
+  CHECK(load_galactic_history("late_date_merge.txt", &history) == 0);
+
+  struct name_pool_stats_t before, after;
+  CHECK(get_name_pool_stats(history, &before) == 0);
+  struct fleet_status_t *fleets[3] = {make_fleet("C"), make_fleet("D"), NULL};
+  fleets[2] = fleets[0];
+  CHECK(add_fleets_to_battle(history, "Endor", 5, fleets, 3) == 1);
+  CHECK(get_name_pool_stats(history, &after) == 0);
+  CHECK(after.names_interned == before.names_interned && after.bytes_requested == before.bytes_requested);
+  CHECK(strcmp(fleets[0]->fleet_name, "C") == 0);
+
+  CHECK(add_fleets_to_battle(history, "Endor", 5, fleets, 2) == 0);
+  CHECK(get_name_pool_stats(history, &after) == 0);
+  CHECK(after.names_interned == before.names_interned + 2);
+  struct battle_node_t *node = find_battle_node(history, "Endor", 5);
+  CHECK(node && node->battle->num_fleets == 4);
+  destroy_galactic_history(&history);
+}
+
+
+int main(void){
+  const char *loaders[] = {"fgets", "mmap", "parallel"};
+  for (int kind = 0; kind < 3; ++kind){
+    printf("late_date_merge (%s)\n", loaders[kind]);
+    test_late_date_merge(kind);
+    printf("unknown_statuses (%s)\n", loaders[kind]);
+    test_unknown_statuses(kind);
+  }
+  printf("snapshot_then_load\n");
+  test_snapshot_then_load();
+  printf("bulk_add_repeated_fleet\n");
+  test_bulk_add_repeated_fleet();
+
+  printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}